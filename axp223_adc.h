@@ -0,0 +1,204 @@
+#ifndef AXP223_ADC_H
+#define AXP223_ADC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "axp223_log.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AXP_ADC_NEON 1
+#endif
+
+// ==========================
+// Batch-Umrechnung der ADC-Werte
+// ==========================
+// Converts raw ADC register pairs to fixed-point engineering units for
+// whole arrays at once and reduces min/max/sum in the same pass:
+//   voltage: 12 bit (high << 4 | low & 0x0F) * 1.1 mV  -> 0.1 mV
+//   current: 13 bit (high << 5 | low & 0x1F) * 0.5 mA  -> 0.1 mA
+//   temp:    12 bit (high << 4 | low & 0x0F) * 0.1 - 144.7 degC -> 0.1 degC
+// Inputs are either planar high/low byte arrays or the interleaved sample
+// stream of the binary log (axp_log_record). On ARMv7 with NEON eight
+// samples are converted per step (log records are transposed 8x8 in
+// registers); elsewhere the scalar loops are written so the compiler can
+// vectorize them. Output arrays may be NULL when only the statistics are
+// needed, which keeps post-processing of long logs bandwidth bound.
+
+typedef enum {
+    AXP_ADC_VOLTAGE,
+    AXP_ADC_CURRENT,
+    AXP_ADC_TEMP,
+    AXP_ADC_KINDS,
+} axp_adc_kind;
+
+// Channel order of axp_adc_convert_records()
+enum {
+    AXP_ADC_CH_VBAT,
+    AXP_ADC_CH_ICHG,
+    AXP_ADC_CH_IDIS,
+    AXP_ADC_CH_TEMP,
+    AXP_ADC_CHANNELS,
+};
+
+typedef struct {
+    int32_t min, max;
+    int64_t sum;
+    uint64_t n;
+} axp_adc_stats;
+
+static const struct {
+    uint8_t shift;      // Bits im Low-Register
+    int32_t mul;        // 0.1-Einheiten pro LSB
+    int32_t offset;
+} axp_adc_scale[AXP_ADC_KINDS] = {
+    [AXP_ADC_VOLTAGE] = { 4, 11, 0 },
+    [AXP_ADC_CURRENT] = { 5, 5, 0 },
+    [AXP_ADC_TEMP]    = { 4, 1, -1447 },
+};
+
+static inline void axp_adc_stats_init(axp_adc_stats* st) {
+    st->min = INT32_MAX;
+    st->max = INT32_MIN;
+    st->sum = 0;
+    st->n = 0;
+}
+
+static inline int32_t axp_adc_convert_one(axp_adc_kind kind, uint8_t hi, uint8_t lo) {
+    uint8_t shift = axp_adc_scale[kind].shift;
+    uint32_t raw = ((uint32_t)hi << shift) | (lo & ((1u << shift) - 1));
+    return (int32_t)raw * axp_adc_scale[kind].mul + axp_adc_scale[kind].offset;
+}
+
+// Scalar tail (and the whole job without NEON)
+static inline void axp_adc_convert_scalar(axp_adc_kind kind, const uint8_t* hi, const uint8_t* lo,
+                                          size_t stride, size_t n, int32_t* out, axp_adc_stats* st) {
+    int32_t min = st->min, max = st->max;
+    int64_t sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        int32_t v = axp_adc_convert_one(kind, hi[i * stride], lo[i * stride]);
+        if (out)
+            out[i] = v;
+        min = v < min ? v : min;
+        max = v > max ? v : max;
+        sum += v;
+    }
+    st->min = min;
+    st->max = max;
+    st->sum += sum;
+    st->n += n;
+}
+
+#ifdef AXP_ADC_NEON
+
+typedef struct {
+    int32x4_t min, max;
+    int64x2_t sum;
+} axp_adc_acc;
+
+static inline void axp_adc_acc_init(axp_adc_acc* a) {
+    a->min = vdupq_n_s32(INT32_MAX);
+    a->max = vdupq_n_s32(INT32_MIN);
+    a->sum = vdupq_n_s64(0);
+}
+
+static inline void axp_adc_acc_finish(const axp_adc_acc* a, axp_adc_stats* st, size_t n) {
+    int32_t mins[4], maxs[4];
+    int64_t sums[2];
+    vst1q_s32(mins, a->min);
+    vst1q_s32(maxs, a->max);
+    vst1q_s64(sums, a->sum);
+    for (int i = 0; i < 4; ++i) {
+        st->min = mins[i] < st->min ? mins[i] : st->min;
+        st->max = maxs[i] > st->max ? maxs[i] : st->max;
+    }
+    st->sum += sums[0] + sums[1];
+    st->n += n;
+}
+
+// Eight samples: combine, scale, store, reduce
+static inline void axp_adc_neon8(axp_adc_kind kind, uint8x8_t hi, uint8x8_t lo, int32_t* out, axp_adc_acc* a) {
+    uint8_t shift = axp_adc_scale[kind].shift;
+    uint16x8_t raw = vorrq_u16(vshlq_u16(vmovl_u8(hi), vdupq_n_s16(shift)),
+                               vmovl_u8(vand_u8(lo, vdup_n_u8((1u << shift) - 1))));
+    int32x4_t off = vdupq_n_s32(axp_adc_scale[kind].offset);
+    uint16_t mul = (uint16_t)axp_adc_scale[kind].mul;
+    int32x4_t v0 = vaddq_s32(vreinterpretq_s32_u32(vmull_n_u16(vget_low_u16(raw), mul)), off);
+    int32x4_t v1 = vaddq_s32(vreinterpretq_s32_u32(vmull_n_u16(vget_high_u16(raw), mul)), off);
+    if (out) {
+        vst1q_s32(out, v0);
+        vst1q_s32(out + 4, v1);
+    }
+    a->min = vminq_s32(a->min, vminq_s32(v0, v1));
+    a->max = vmaxq_s32(a->max, vmaxq_s32(v0, v1));
+    a->sum = vpadalq_s32(a->sum, vaddq_s32(v0, v1));
+}
+
+#endif // AXP_ADC_NEON
+
+// Planar input: hi[i], lo[i] are the register pair of sample i
+static inline void axp_adc_convert(axp_adc_kind kind, const uint8_t* hi, const uint8_t* lo, size_t n,
+                                   int32_t* out, axp_adc_stats* st) {
+    size_t i = 0;
+#ifdef AXP_ADC_NEON
+    axp_adc_acc acc;
+    axp_adc_acc_init(&acc);
+    for (; i + 8 <= n; i += 8)
+        axp_adc_neon8(kind, vld1_u8(hi + i), vld1_u8(lo + i), out ? out + i : NULL, &acc);
+    axp_adc_acc_finish(&acc, st, i);
+#endif
+    axp_adc_convert_scalar(kind, hi + i, lo + i, 1, n - i, out ? out + i : NULL, st);
+}
+
+// Interleaved log records: all four channels in one pass. `out[ch]` may be
+// NULL per channel; `st` has AXP_ADC_CHANNELS entries.
+static inline void axp_adc_convert_records(const axp_log_record* rec, size_t n, int32_t* const out[AXP_ADC_CHANNELS],
+                                           axp_adc_stats st[AXP_ADC_CHANNELS]) {
+    static const struct {
+        axp_adc_kind kind;
+        uint8_t hi, lo;
+    } ch[AXP_ADC_CHANNELS] = {
+        [AXP_ADC_CH_VBAT] = { AXP_ADC_VOLTAGE, AXP_LOG_RAW_VBAT_H, AXP_LOG_RAW_VBAT_L },
+        [AXP_ADC_CH_ICHG] = { AXP_ADC_CURRENT, AXP_LOG_RAW_ICHG_H, AXP_LOG_RAW_ICHG_L },
+        [AXP_ADC_CH_IDIS] = { AXP_ADC_CURRENT, AXP_LOG_RAW_IDIS_H, AXP_LOG_RAW_IDIS_L },
+        [AXP_ADC_CH_TEMP] = { AXP_ADC_TEMP,    AXP_LOG_RAW_TEMP_H, AXP_LOG_RAW_TEMP_L },
+    };
+    size_t i = 0;
+
+#ifdef AXP_ADC_NEON
+    axp_adc_acc acc[AXP_ADC_CHANNELS];
+    for (int c = 0; c < AXP_ADC_CHANNELS; ++c)
+        axp_adc_acc_init(&acc[c]);
+
+    for (; i + 8 <= n; i += 8) {
+        // 8 Records x 8 Rohbytes transponieren: danach r[k] = Byte k aller 8 Samples
+        uint8x8_t r[8];
+        for (int k = 0; k < 8; ++k)
+            r[k] = vld1_u8(rec[i + k].raw);
+        for (int k = 0; k < 8; k += 2) {
+            uint8x8x2_t t = vtrn_u8(r[k], r[k + 1]);
+            r[k] = t.val[0], r[k + 1] = t.val[1];
+        }
+        for (int k = 0; k < 8; k += 4) {
+            for (int j = 0; j < 2; ++j) {
+                uint16x4x2_t t = vtrn_u16(vreinterpret_u16_u8(r[k + j]), vreinterpret_u16_u8(r[k + j + 2]));
+                r[k + j] = vreinterpret_u8_u16(t.val[0]), r[k + j + 2] = vreinterpret_u8_u16(t.val[1]);
+            }
+        }
+        for (int j = 0; j < 4; ++j) {
+            uint32x2x2_t t = vtrn_u32(vreinterpret_u32_u8(r[j]), vreinterpret_u32_u8(r[j + 4]));
+            r[j] = vreinterpret_u8_u32(t.val[0]), r[j + 4] = vreinterpret_u8_u32(t.val[1]);
+        }
+        for (int c = 0; c < AXP_ADC_CHANNELS; ++c)
+            axp_adc_neon8(ch[c].kind, r[ch[c].hi], r[ch[c].lo], out[c] ? out[c] + i : NULL, &acc[c]);
+    }
+    for (int c = 0; c < AXP_ADC_CHANNELS; ++c)
+        axp_adc_acc_finish(&acc[c], &st[c], i);
+#endif
+
+    for (int c = 0; c < AXP_ADC_CHANNELS; ++c)
+        axp_adc_convert_scalar(ch[c].kind, &rec[i].raw[ch[c].hi], &rec[i].raw[ch[c].lo], sizeof(axp_log_record),
+                               n - i, out[c] ? out[c] + i : NULL, &st[c]);
+}
+
+#endif // AXP223_ADC_H
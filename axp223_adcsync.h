@@ -0,0 +1,226 @@
+#ifndef AXP223_ADCSYNC_H
+#define AXP223_ADCSYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+// ==========================
+// Synchronisation auf den ADC-Takt
+// ==========================
+// The AXP223 converts its ADC channels at the rate set in REG84[7:6]
+// (100, 200, 400 or 800 Hz) and only then updates REG56/57 and
+// REG78–REG7D. Polling faster reads the same conversion several times;
+// polling at the same rate but with the wrong phase reads right at the
+// edge and occasionally repeats or skips one.
+//
+// axp_adc_lock keeps a schedule with one read per conversion ("slot"),
+// placed in the middle between two conversion edges. The edges come from
+// the data itself: in a probe window of AXP_ADC_PROBE_SLOTS slots the
+// caller reads AXP_ADC_SUBSTEPS times per slot, and every value change
+// between two reads places an edge between them. Only the measured read
+// times count, not the planned ones, so wakeup latency and slow
+// transactions cost resolution but do not bias the result; edges bracketed
+// less tightly than a quarter period are ignored. The mean offset of the
+// edges from the predicted ones corrects the phase, and, divided by the
+// slots since the previous probe, the period (the PMIC's RC oscillator is
+// not the CPU clock). Probes start every AXP_ADC_PROBE_MIN slots and space
+// out to AXP_ADC_PROBE_MAX as the estimate settles. A probe without a
+// usable edge (static signal, no ADC noise) leaves the estimate alone; one
+// more than a quarter period off counts as a lost lock and starts over.
+//
+// With a stride of n only every n-th conversion is read; the schedule jumps
+// from one to the next and only the probe windows read every slot. Each read
+// is mapped to the conversion it saw by its measured time, and a conversion
+// is handed out at most once: a read that lands on one already handed out
+// (early wakeup, phase still off) is a duplicate. The ADC values play no
+// part in that, an unchanged reading is a perfectly valid new sample.
+//
+// The lock does no I/O. The caller waits until axp_adc_lock_next(), reads,
+// and passes the ADC bytes to axp_adc_lock_feed(), which says whether the
+// read is a sample to keep.
+
+#define AXP_ADC_RATE_REG    0x84
+#define AXP_ADC_SUBSTEPS    8
+#define AXP_ADC_PROBE_SLOTS 4
+#define AXP_ADC_PROBE_MIN   8
+#define AXP_ADC_PROBE_MAX   1024
+#define AXP_ADC_LOCK_BYTES  8       // REG78..REG7D + REG56/57
+
+// REG84[7:6]: 100 << n Hz
+static inline unsigned axp_adc_rate_hz(uint8_t reg84) {
+    return 100u << (reg84 >> 6);
+}
+
+// Bits 7:6 for `hz`, -1 if the ADC cannot run at that rate
+static inline int axp_adc_rate_bits(unsigned hz) {
+    for (int n = 0; n < 4; ++n)
+        if (hz == 100u << n)
+            return n << 6;
+    return -1;
+}
+
+typedef struct {
+    uint32_t stride;            // jede n-te Wandlung ausgeben
+    uint64_t emit_next;         // erste noch nicht ausgegebene Wandlung (Raster)
+    uint64_t nominal_ps;        // Periode laut REG84
+    uint64_t period_ps;         // geschaetzte Periode
+    uint64_t anchor_ns;         // Wandlungsflanke zu Beginn von anchor_slot
+    uint64_t anchor_slot;
+    uint64_t slot;              // aktueller Slot (fortlaufend)
+    uint8_t step;               // 0 = regulaere Lesung, sonst Probe-Zwischenschritt
+    uint64_t next_probe;        // erster Slot des naechsten Probe-Fensters
+    uint64_t last_probe;        // erster Slot des letzten ausgewerteten Fensters
+    uint32_t interval;          // Slots zwischen zwei Probes
+    bool locked;                // Phase mindestens einmal gemessen
+
+    int64_t err_sum;            // Flankenabweichungen im laufenden Fenster (ns)
+    int64_t err_first;
+    uint32_t err_n;
+    bool have_last;
+    uint64_t last_ns;           // Mitte der letzten Lesung
+    uint8_t last[AXP_ADC_LOCK_BYTES];
+
+    uint64_t probes, probe_reads, edges, empty_probes, relocks, duplicates;
+} axp_adc_lock;
+
+static inline void axp_adc_lock_init(axp_adc_lock* l, unsigned rate_hz, unsigned stride, uint64_t now_ns) {
+    memset(l, 0, sizeof(*l));
+    l->stride = stride ? stride : 1;
+    l->nominal_ps = l->period_ps = 1000000000000ull / rate_hz;
+    l->anchor_ns = now_ns;      // beliebige Phase bis zur ersten Probe
+    l->interval = AXP_ADC_PROBE_MIN;
+}
+
+static inline bool axp_adc_lock_probing(const axp_adc_lock* l) {
+    return l->slot >= l->next_probe;
+}
+
+// Planned time of the next read
+static inline uint64_t axp_adc_lock_next(const axp_adc_lock* l) {
+    uint64_t t_ps = (l->slot - l->anchor_slot) * l->period_ps + l->period_ps / 2 +
+                    l->step * l->period_ps / AXP_ADC_SUBSTEPS;
+    return l->anchor_ns + t_ps / 1000;
+}
+
+// Probe window done: shift the phase by the mean edge offset and correct
+// the period by the drift since the previous probe
+static inline void axp_adc_lock_correct(axp_adc_lock* l) {
+    l->probes++;
+    if (l->err_n) {
+        int64_t err = l->err_sum / l->err_n;
+        uint64_t edge_ps = (l->slot - l->anchor_slot) * l->period_ps;
+        l->anchor_ns += edge_ps / 1000 + err;
+        l->anchor_slot = l->slot;
+        bool settled = l->interval >= 4 * AXP_ADC_PROBE_MIN;
+        if (settled && (err > (int64_t)(l->period_ps / 4000) || -err > (int64_t)(l->period_ps / 4000))) {
+            // Eingeschwungen und trotzdem mehr als eine Viertelperiode daneben:
+            // Lock verloren (z.B. REG84 umgestellt), nur die Phase uebernehmen
+            // und neu einschwingen
+            l->relocks++;
+            l->interval = AXP_ADC_PROBE_MIN / 2;
+        } else if (l->locked) {
+            int64_t since = (int64_t)(l->next_probe - l->last_probe);
+            int64_t period = (int64_t)l->period_ps + err * 1000 / since;
+            // Mehr als 10 % neben REG84 ist kein Oszillatorfehler mehr
+            int64_t lo = l->nominal_ps * 9 / 10, hi = l->nominal_ps * 11 / 10;
+            l->period_ps = period < lo ? lo : period > hi ? hi : period;
+        }
+        // Erst nach der ersten Frequenzkorrektur weiter auseinander, damit
+        // ein Oszillatorfehler von einigen Prozent nicht schon umschlaegt
+        if (l->locked && l->interval < AXP_ADC_PROBE_MAX)
+            l->interval *= 2;
+        l->locked = true;
+        l->last_probe = l->next_probe;
+    } else {
+        // Ohne Lock trotzdem seltener proben (ruhiges Signal kostet sonst nur
+        // Bus); mit Lock nicht, sonst waechst die Drift bis zur naechsten
+        // Flanke ueber eine halbe Periode
+        l->empty_probes++;
+        if (!l->locked && l->interval < AXP_ADC_PROBE_MAX)
+            l->interval *= 2;
+    }
+    l->next_probe = l->slot + l->interval;
+    l->err_sum = 0;
+    l->err_n = 0;
+}
+
+// Offset of an edge at `t_ns` from the nearest predicted one, in ns
+static inline int64_t axp_adc_lock_offset(const axp_adc_lock* l, uint64_t t_ns) {
+    int64_t p = (int64_t)l->period_ps;
+    int64_t rel = ((int64_t)t_ns - (int64_t)l->anchor_ns) * 1000 % p;
+    rel += rel < -p / 2 ? p : rel >= p / 2 ? -p : 0;
+    return rel / 1000;
+}
+
+// Conversion in effect at `t_ns` by the current estimate: the slot whose
+// edge is the last one before it
+static inline uint64_t axp_adc_lock_conversion(const axp_adc_lock* l, uint64_t t_ns) {
+    int64_t d = ((int64_t)t_ns - (int64_t)l->anchor_ns) * 1000;
+    int64_t k = d / (int64_t)l->period_ps;
+    k -= d < 0 && d % (int64_t)l->period_ps != 0;
+    return k < 0 && (uint64_t)-k > l->anchor_slot ? 0 : l->anchor_slot + k;
+}
+
+// Account one read planned for `planned_ns` that ran from `t0_ns` to
+// `t1_ns`; `val` is NULL after a read error. Returns true if the read is a
+// sample to keep, with the conversions on the stride grid that were passed
+// over in `missed`.
+static inline bool axp_adc_lock_feed(axp_adc_lock* l, const uint8_t* val, uint64_t planned_ns,
+                                     uint64_t t0_ns, uint64_t t1_ns, unsigned* missed) {
+    bool probing = axp_adc_lock_probing(l);
+    uint64_t mid_ns = t0_ns + (t1_ns - t0_ns) / 2;
+    bool emit = false;
+    *missed = 0;
+    if (l->step == 0 && l->slot >= l->emit_next) {
+        // Zur Ausgabe geplant: es zaehlt die gemessene Wandlung, nicht der Slot
+        uint64_t conv = axp_adc_lock_conversion(l, mid_ns);
+        if (conv < l->emit_next) {
+            l->duplicates++;
+        } else {
+            uint64_t gap = (conv - l->emit_next) / l->stride;
+            *missed = gap > UINT32_MAX ? UINT32_MAX : (unsigned)gap;
+            l->emit_next = conv + l->stride;
+            emit = true;
+        }
+    }
+    if (probing) {
+        l->probe_reads += l->step != 0;
+        // Flanke irgendwo zwischen den beiden Lesungen: nur eng eingegrenzte zaehlen
+        if (l->have_last && val && memcmp(val, l->last, AXP_ADC_LOCK_BYTES) != 0 &&
+            (mid_ns - l->last_ns) * 4000 <= l->period_ps) {
+            // Um die erste Flanke des Fensters auswickeln: Abweichungen nahe
+            // +-P/2 sollen sich nicht zu 0 mitteln
+            int64_t p = (int64_t)(l->period_ps / 1000);
+            int64_t err = axp_adc_lock_offset(l, l->last_ns + (mid_ns - l->last_ns) / 2);
+            if (!l->err_n)
+                l->err_first = err;
+            err += err - l->err_first > p / 2 ? -p : l->err_first - err > p / 2 ? p : 0;
+            l->err_sum += err;
+            l->err_n++;
+            l->edges++;
+        }
+    }
+    l->have_last = val != NULL;
+    l->last_ns = mid_ns;
+    if (val)
+        memcpy(l->last, val, AXP_ADC_LOCK_BYTES);
+
+    if (probing && ++l->step < AXP_ADC_SUBSTEPS)
+        return emit;
+    l->step = 0;
+    if (t0_ns > planned_ns)
+        l->slot += (t0_ns - planned_ns) * 1000 / l->period_ps;     // zu spaet, Slots uebersprungen
+    l->slot++;
+    if (probing && l->slot >= l->next_probe + AXP_ADC_PROBE_SLOTS)
+        axp_adc_lock_correct(l);
+    // Ausserhalb der Probes direkt zur naechsten auszugebenden Wandlung
+    if (!axp_adc_lock_probing(l)) {
+        uint64_t to = l->emit_next < l->next_probe ? l->emit_next : l->next_probe;
+        if (l->slot < to)
+            l->slot = to;
+    }
+    return emit;
+}
+
+#endif // AXP223_ADCSYNC_H
@@ -0,0 +1,27 @@
+#ifndef AXP223_API_H
+#define AXP223_API_H
+
+// ==========================
+// Bindung der gemeinsamen Helfer
+// ==========================
+// Linkage of the transaction layer, decoder, simulator, metrics and axpd
+// client helpers. Built as a separate tool, each source gets its own
+// static inline copy as before. The multi-call build defines AXP_SHARED
+// for every applet. The applets then see C99 inline definitions, which are
+// never emitted out of line; calls that the compiler does not inline go to
+// the single external copy built by axp223_lib.c (AXP_IMPL). Tables are
+// defined only there and declared extern everywhere else (AXP_EXTERN_DATA).
+
+#if !defined(AXP_SHARED)
+#define AXP_API static inline
+#define AXP_DATA static
+#elif defined(AXP_IMPL)
+#define AXP_API extern inline
+#define AXP_DATA
+#else
+#define AXP_API inline
+#define AXP_DATA
+#define AXP_EXTERN_DATA
+#endif
+
+#endif // AXP223_API_H
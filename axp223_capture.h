@@ -0,0 +1,181 @@
+#ifndef AXP223_CAPTURE_H
+#define AXP223_CAPTURE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "axp223_log.h"
+
+// ==========================
+// Pre-Trigger-Aufzeichnung
+// ==========================
+// Like an oscilloscope: the sampler keeps the last `pre` ADC samples in a
+// circular buffer. When a sample shows a configured IRQ status bit
+// (REG48–REG4C), the buffer is frozen, `post` more samples are collected,
+// and the whole window is appended to the capture file as one event.
+// Between events nothing is written, however high the sampling rate.
+//
+// File layout:
+//   [axp_capture_header, 64 bytes]
+//   per event: [axp_capture_event, 32 bytes][axp_log_record, 16 bytes] * n
+// with n = pre_count + 1 + post_count; record pre_count is the sample
+// that carried the trigger. Records are the same raw ADC records as in the
+// sample log, so axplog_decode converts both.
+
+#define AXP_CAPTURE_MAGIC   "AXPCAP1"
+#define AXP_CAPTURE_VERSION 1
+#define AXP_CAPTURE_MAX     4096    // Obergrenze fuer pre und post
+#define AXP_CAPTURE_IRQ_FIRST 0x48
+#define AXP_CAPTURE_IRQ_COUNT 5
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t event_size;
+    uint32_t record_size;
+    uint64_t start_ns;          // CLOCK_MONOTONIC beim Start
+    uint32_t rate_hz;
+    uint16_t pre;
+    uint16_t post;
+    uint8_t trigger[AXP_CAPTURE_IRQ_COUNT];     // Masken fuer REG48..REG4C
+    uint8_t dev_addr;
+    uint8_t reserved[18];
+} axp_capture_header;
+
+typedef struct {
+    uint64_t t_ns;              // Zeit des ausloesenden Samples
+    uint8_t irq[AXP_CAPTURE_IRQ_COUNT];         // ausgeloeste Bits (auch waehrend post)
+    uint8_t reserved0;
+    uint16_t pre_count;         // weniger als pre, wenn kurz nach Start/Event
+    uint16_t post_count;        // weniger als post, wenn vorher beendet
+    uint16_t read_errors;       // fehlende Samples im Fenster
+    uint8_t reserved[12];
+} axp_capture_event;
+
+_Static_assert(sizeof(axp_capture_header) == 64, "capture header must be 64 bytes");
+_Static_assert(sizeof(axp_capture_event) == 32, "capture event must be 32 bytes");
+
+typedef struct {
+    int fd;
+    uint16_t pre, post;
+    uint8_t trigger[AXP_CAPTURE_IRQ_COUNT];
+    uint64_t events;
+
+    // Pre-Trigger-Ring
+    axp_log_record ring[AXP_CAPTURE_MAX];
+    uint32_t ring_head, ring_count;
+
+    // laufendes Event: Kopf und Records am Stueck, ein write() pro Event
+    bool armed;                 // false: sammelt post-Samples
+    struct {
+        axp_capture_event ev;
+        axp_log_record rec[2 * AXP_CAPTURE_MAX + 1];
+    } cur;
+} axp_capture;
+
+static inline int axp_capture_open(axp_capture* c, const char* path, uint8_t dev_addr, uint32_t rate_hz,
+                                   uint64_t start_ns, uint16_t pre, uint16_t post, const uint8_t* trigger) {
+    memset(&c->cur.ev, 0, sizeof(c->cur.ev));
+    c->pre = pre;
+    c->post = post;
+    memcpy(c->trigger, trigger, sizeof(c->trigger));
+    c->events = 0;
+    c->ring_head = c->ring_count = 0;
+    c->armed = true;
+
+    c->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (c->fd < 0)
+        return -1;
+
+    axp_capture_header hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, AXP_CAPTURE_MAGIC, sizeof(AXP_CAPTURE_MAGIC));
+    hdr.version = AXP_CAPTURE_VERSION;
+    hdr.header_size = sizeof(hdr);
+    hdr.event_size = sizeof(axp_capture_event);
+    hdr.record_size = sizeof(axp_log_record);
+    hdr.start_ns = start_ns;
+    hdr.rate_hz = rate_hz;
+    hdr.pre = pre;
+    hdr.post = post;
+    memcpy(hdr.trigger, trigger, sizeof(hdr.trigger));
+    hdr.dev_addr = dev_addr;
+    if (write(c->fd, &hdr, sizeof(hdr)) != (ssize_t)sizeof(hdr)) {
+        close(c->fd);
+        c->fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+static inline int axp_capture_flush(axp_capture* c) {
+    axp_capture_event* ev = &c->cur.ev;
+    size_t len = sizeof(*ev) + ((size_t)ev->pre_count + 1 + ev->post_count) * sizeof(axp_log_record);
+    c->armed = true;
+    c->ring_count = 0;      // Fenster ueberlappen nicht
+    c->events++;
+    return write(c->fd, &c->cur, len) == (ssize_t)len ? 0 : -1;
+}
+
+// Feed one sample; `irq` is REG48..REG4C as read with it, `rec` NULL for a
+// read error. Returns -1 if writing an event failed.
+static inline int axp_capture_add(axp_capture* c, const axp_log_record* rec, const uint8_t* irq) {
+    axp_capture_event* ev = &c->cur.ev;
+    if (!rec) {
+        if (!c->armed)
+            ev->read_errors++;
+        return 0;
+    }
+
+    uint8_t hit[AXP_CAPTURE_IRQ_COUNT];
+    bool fired = false;
+    for (int i = 0; i < AXP_CAPTURE_IRQ_COUNT; ++i) {
+        hit[i] = irq[i] & c->trigger[i];
+        fired |= hit[i] != 0;
+    }
+
+    if (!c->armed) {
+        c->cur.rec[ev->pre_count + 1 + ev->post_count++] = *rec;
+        for (int i = 0; i < AXP_CAPTURE_IRQ_COUNT; ++i)
+            ev->irq[i] |= hit[i];
+        return ev->post_count == c->post ? axp_capture_flush(c) : 0;
+    }
+
+    if (fired) {
+        // Ring in zeitlicher Reihenfolge vor das ausloesende Sample kopieren
+        memset(ev, 0, sizeof(*ev));
+        ev->t_ns = rec->t_ns;
+        memcpy(ev->irq, hit, sizeof(ev->irq));
+        ev->pre_count = c->ring_count;
+        uint32_t first = (c->ring_head + c->pre - c->ring_count) % (c->pre ? c->pre : 1);
+        for (uint32_t i = 0; i < c->ring_count; ++i)
+            c->cur.rec[i] = c->ring[(first + i) % c->pre];
+        c->cur.rec[ev->pre_count] = *rec;
+        c->armed = false;
+        return c->post == 0 ? axp_capture_flush(c) : 0;
+    }
+
+    if (c->pre) {
+        c->ring[c->ring_head] = *rec;
+        c->ring_head = (c->ring_head + 1) % c->pre;
+        if (c->ring_count < c->pre)
+            c->ring_count++;
+    }
+    return 0;
+}
+
+// Write an event still collecting post samples (shortened) and close.
+static inline void axp_capture_close(axp_capture* c) {
+    if (c->fd < 0)
+        return;
+    if (!c->armed && axp_capture_flush(c) < 0)
+        perror("Write capture event failed");
+    close(c->fd);
+    c->fd = -1;
+}
+
+#endif // AXP223_CAPTURE_H
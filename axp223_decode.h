@@ -0,0 +1,746 @@
+#ifndef AXP223_DECODE_H
+#define AXP223_DECODE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include "axp223_api.h"
+#include "axp223_i2c.h"
+
+// ==========================
+// Tabellengesteuerter Decoder
+// ==========================
+// Every decoded register (or register pair) is described once in
+// axp_decode_table[] as a list of bitfields. One generic decoder walks the
+// table against a snapshot and renders into a caller-provided buffer, which
+// is flushed with a single write(). Numeric values are fixed point
+// (raw * mul + offset, with `decimals` implied decimal places), so no float
+// formatting is involved.
+//
+// Adding a register is one table entry; adding a field is one line.
+
+typedef enum {
+    AXP_F_BOOL,     // 1 bit, labels[0] / labels[1]
+    AXP_F_ENUM,     // width bits, labels[raw]
+    AXP_F_FLAG,     // 1 bit, only shown when set (IRQ status)
+    AXP_F_LOOKUP,   // width bits, values[raw] in `unit`, < 0 = reserved
+    AXP_F_SCALED,   // raw * mul + offset, `decimals` fixed-point digits
+    AXP_F_HEX,      // raw bits as hex
+} axp_field_kind;
+
+typedef struct {
+    const char* key;        // Maschinenname, z.B. "pek_short"
+    const char* name;
+    uint8_t kind;
+    uint8_t shift;
+    uint8_t width;
+    const char* const* labels;
+    const int16_t* values;
+    int32_t mul;
+    int32_t offset;
+    uint8_t decimals;
+    const char* unit;
+} axp_field;
+
+typedef struct {
+    uint8_t reg;            // erstes Register
+    uint8_t nregs;          // 1 oder 2
+    uint8_t split;          // 2 Register: Bits im Low-Register (ADC), 0 = 16-Bit-Wort
+    const char* group;      // Schluessel-Praefix ("irq" -> "irq.pek_short"), NULL = keins
+    const char* title;      // NULL: Felder ohne Ueberschrift ausgeben
+    const axp_field* fields;
+    uint8_t nfields;
+} axp_reg_desc;
+
+#define AXP_LABELS(...) ((const char* const[]){ __VA_ARGS__ })
+#define AXP_VALUES(...) ((const int16_t[]){ __VA_ARGS__ })
+
+#define AXP_BOOL(bit, key, name, off, on) \
+    { key, name, AXP_F_BOOL, bit, 1, AXP_LABELS(off, on), NULL, 0, 0, 0, NULL }
+#define AXP_YESNO(bit, key, name) AXP_BOOL(bit, key, name, "No", "Yes")
+#define AXP_ENUM(shift, width, key, name, ...) \
+    { key, name, AXP_F_ENUM, shift, width, AXP_LABELS(__VA_ARGS__), NULL, 0, 0, 0, NULL }
+#define AXP_FLAG(bit, key, name) \
+    { key, name, AXP_F_FLAG, bit, 1, NULL, NULL, 0, 0, 0, NULL }
+#define AXP_LOOKUP(shift, width, key, name, unit, ...) \
+    { key, name, AXP_F_LOOKUP, shift, width, NULL, AXP_VALUES(__VA_ARGS__), 0, 0, 0, unit }
+#define AXP_SCALED(shift, width, key, name, mul, offset, decimals, unit) \
+    { key, name, AXP_F_SCALED, shift, width, NULL, NULL, mul, offset, decimals, unit }
+#define AXP_HEX(shift, width, key, name) \
+    { key, name, AXP_F_HEX, shift, width, NULL, NULL, 0, 0, 0, NULL }
+
+#define AXP_REG(reg, group, title, fields) \
+    { reg, 1, 0, group, title, fields, sizeof(fields) / sizeof(fields[0]) }
+#define AXP_ADC(reg, split, fields) \
+    { reg, 2, split, NULL, NULL, fields, sizeof(fields) / sizeof(fields[0]) }
+
+// Charge current steps shared by REG33 and REG35 (mA)
+#define AXP_CC_STEPS 300, 450, 600, 750, 900, 1050, 1200, 1350, \
+                     1500, 1650, 1800, 1950, 2100
+
+#define AXP_DECODE_COUNT 19
+
+#ifdef AXP_EXTERN_DATA
+// Multi-Call-Build: die Tabelle liegt einmal in axp223_lib.c
+extern const axp_reg_desc axp_decode_table[AXP_DECODE_COUNT];
+#else
+
+static const axp_field axp_fields_reg00[] = {
+    AXP_YESNO(7, "acin_present", "ACIN Present"),
+    AXP_YESNO(6, "acin_usable", "ACIN Usable"),
+    AXP_YESNO(5, "vbus_present", "VBUS Present"),
+    AXP_YESNO(4, "vbus_usable", "VBUS Usable"),
+    AXP_YESNO(3, "vbus_above_vhold", "VBUS > VHOLD"),
+    AXP_BOOL(2, "battery_charging", "Battery direction", "discharging", "charging"),
+    AXP_YESNO(1, "acin_vbus_short", "ACIN/VBUS Short"),
+    AXP_YESNO(0, "extpwr_poweron", "Power-on via ExtPwr"),
+};
+
+static const axp_field axp_fields_reg01[] = {
+    AXP_YESNO(7, "overtemperature", "Overtemperature"),
+    AXP_YESNO(6, "charging", "Charging"),
+    AXP_YESNO(5, "battery_present", "Battery Present"),
+    AXP_YESNO(3, "battery_activation", "Battery Activation"),
+};
+
+static const axp_field axp_fields_reg32[] = {
+    AXP_BOOL(7, "sw_shutdown", "Software Shutdown (bit 7)", "Inactive", "Active (shutdown requested)"),
+    AXP_BOOL(6, "battery_detection", "Battery Detection (bit 6)", "Disabled", "Enabled"),
+    AXP_ENUM(4, 2, "chgled_mode", "CHGLED Mode (bits 5-4)",
+             "High-Z (off)", "25% Duty @ 0.5 Hz (slow blink)",
+             "25% Duty @ 2 Hz (fast blink)", "Low Level (ON)"),
+    AXP_BOOL(3, "chgled_auto", "CHGLED Source (bit 3)", "Manual (via bits 5-4)", "Automatic (charger-controlled)"),
+    AXP_BOOL(2, "poweroff_sequenced", "Power-Off Timing (bit 2)", "All at once", "Sequenced off (reverse start order)"),
+    AXP_ENUM(0, 2, "pwrok_delay", "PWROK Delay (bits 1-0)",
+             "8 ms after last rail", "16 ms after last rail",
+             "32 ms after last rail", "64 ms after last rail"),
+};
+
+static const axp_field axp_fields_reg33[] = {
+    AXP_YESNO(7, "enabled", "Charging Enabled (bit 7)"),
+    AXP_ENUM(5, 2, "target_voltage", "Charge Target Voltage (6:5)", "4.1V", "4.22V", "4.2V", "4.24V"),
+    AXP_BOOL(4, "end_of_charge_15pct", "End-of-Charge Threshold", "<10% of CC", "<15% of CC"),
+    AXP_LOOKUP(0, 4, "current_ma", "Charge Current (3:0)", "mA", AXP_CC_STEPS, -1, -1, -1),
+};
+
+static const axp_field axp_fields_reg34[] = {
+    AXP_ENUM(6, 2, "precharge_timeout", "Pre-charge Timeout (7:6)", "40 min", "50 min", "60 min", "70 min"),
+    AXP_BOOL(5, "keep_output", "Keep Charging Output (bit 5)", "No (disable)", "Yes (remain active)"),
+    AXP_BOOL(4, "chgled_type_b", "CHGLED Mode Type (bit 4)", "Type A (solid/low)", "Type B (blink)"),
+    AXP_BOOL(2, "sync_current", "Sync on Current Change (bit 2)", "No (ignore until reset)", "Yes (dynamic adjust)"),
+    AXP_ENUM(0, 2, "cc_timeout", "CC Timeout (1:0)", "6h", "8h", "10h", "12h"),
+};
+
+static const axp_field axp_fields_reg35[] = {
+    AXP_LOOKUP(0, 4, "loop_current_limit_ma", "Loop Charging Current Limit", "mA", AXP_CC_STEPS, 2250, -1, -1),
+};
+
+// ADC: 12 bit (high << 4 | low & 0x0F) bzw. 13 bit (high << 5 | low & 0x1F)
+static const axp_field axp_fields_vbat[] = {
+    AXP_SCALED(0, 12, "battery_voltage", "Battery Voltage", 11, 0, 1, "mV"),           // 1.1 mV/LSB
+};
+static const axp_field axp_fields_ichg[] = {
+    AXP_SCALED(0, 13, "charge_current", "Battery Charge Current", 5, 0, 1, "mA"),     // 0.5 mA/LSB
+};
+static const axp_field axp_fields_idis[] = {
+    AXP_SCALED(0, 13, "discharge_current", "Battery Discharge Current", 5, 0, 1, "mA"),
+};
+static const axp_field axp_fields_temp[] = {
+    AXP_SCALED(0, 12, "internal_temp", "Internal Temperature", 1, -1447, 1, "°C"),   // 0.1 K/LSB - 144.7
+};
+
+static const axp_field axp_fields_reg82[] = {
+    AXP_YESNO(7, "ts_pin", "TS Pin ADC Enable"),
+    AXP_YESNO(6, "battery_voltage", "Battery Voltage ADC Enable"),
+    AXP_YESNO(5, "battery_current", "Battery Current ADC Enable"),
+    AXP_HEX(0, 5, "other", "Other ADCs (undocumented)"),     // Bits 4-0 nicht dokumentiert in AXP223 v1.1
+};
+
+static const axp_field axp_fields_reg84[] = {
+    AXP_LOOKUP(6, 2, "sample_rate_hz", "ADC Sample Rate (7:6)", "Hz", 100, 200, 400, 800),
+    AXP_LOOKUP(4, 2, "ts_current_ua", "TS Pin Current (5:4)", "uA", 20, 40, 60, 80),
+    AXP_BOOL(2, "ts_external", "TS Pin Function (bit 2)", "Battery temperature", "External ADC input"),
+    AXP_ENUM(0, 2, "ts_current_mode", "TS Current Output (1:0)",
+             "Off", "While charging", "During ADC sample", "Always on"),
+};
+
+static const axp_field axp_fields_regb8[] = {
+    AXP_YESNO(7, "enabled", "Fuel Gauge Enabled (bit 7)"),
+    AXP_YESNO(6, "coulomb_counter", "Coulomb Counter Enabled (bit 6)"),
+    AXP_BOOL(5, "calibration_requested", "Capacity Calibration Trigger (bit 5)", "Not triggered", "Requested"),
+    AXP_BOOL(4, "calibration_idle", "Calibration Status (bit 4)", "Running", "Not running"),
+    AXP_HEX(0, 4, "reserved", "Reserved Bits (3:0)"),
+};
+
+static const axp_field axp_fields_rege0[] = {
+    AXP_YESNO(15, "configured", "Capacity Configured (bit 7)"),
+    AXP_HEX(0, 15, "raw", "Raw Capacity Setting (14:0)"),
+    AXP_SCALED(0, 15, "mah", "Calculated Battery Capacity", 1456, 0, 3, "mAh"),  // 1.456 mAh/LSB
+};
+
+static const axp_field axp_fields_reg48[] = {
+    AXP_FLAG(7, "acin_overvoltage", "ACIN Over-Voltage"),
+    AXP_FLAG(6, "acin_connected", "ACIN Connected"),
+    AXP_FLAG(5, "acin_removed", "ACIN Removed"),
+    AXP_FLAG(4, "vbus_overvoltage", "VBUS Over-Voltage"),
+    AXP_FLAG(3, "vbus_connected", "VBUS Connected"),
+    AXP_FLAG(2, "vbus_removed", "VBUS Removed"),
+    AXP_FLAG(1, "vbus_below_vhold", "VBUS Below VHOLD"),
+};
+
+static const axp_field axp_fields_reg49[] = {
+    AXP_FLAG(7, "battery_connected", "Battery Connected"),
+    AXP_FLAG(6, "battery_removed", "Battery Removed"),
+    AXP_FLAG(5, "battery_activate_enter", "Battery Entered Activate Mode"),
+    AXP_FLAG(4, "battery_activate_exit", "Battery Exited Activate Mode"),
+    AXP_FLAG(3, "charging", "Battery is Charging"),
+    AXP_FLAG(2, "charge_done", "Charging Finished"),
+    AXP_FLAG(1, "battery_overtemp", "Battery Over-Temperature"),
+    AXP_FLAG(0, "battery_lowtemp", "Battery Low-Temperature"),
+};
+
+static const axp_field axp_fields_reg4a[] = {
+    AXP_FLAG(7, "internal_overtemp", "Internal Over-Temperature"),
+    AXP_FLAG(1, "pek_short", "PEK Short Press"),
+    AXP_FLAG(0, "pek_long", "PEK Long Press"),
+};
+
+static const axp_field axp_fields_reg4b[] = {
+    AXP_FLAG(1, "battery_alarm1", "Battery Alarm Threshold 1 Reached"),
+    AXP_FLAG(0, "battery_alarm2", "Battery Alarm Threshold 2 Reached"),
+};
+
+static const axp_field axp_fields_reg4c[] = {
+    AXP_FLAG(7, "timer", "Timer Timeout"),
+    AXP_FLAG(6, "pek_rising", "PEK Rising Edge"),
+    AXP_FLAG(5, "pek_falling", "PEK Falling Edge"),
+    AXP_FLAG(1, "gpio1_edge", "GPIO1 Edge Trigger"),
+    AXP_FLAG(0, "gpio0_edge", "GPIO0 Edge Trigger"),
+};
+
+// Reihenfolge = Ausgabereihenfolge
+AXP_DATA const axp_reg_desc axp_decode_table[] = {
+    AXP_REG(0x00, "power_status", "REG00 (Power Input Status)", axp_fields_reg00),
+    AXP_REG(0x01, "charge_state", "REG01 (Power Mode / Charge State)", axp_fields_reg01),
+    AXP_REG(0x32, "shutdown", "REG32 (Shutdown, Battery Detection, CHGLED Control)", axp_fields_reg32),
+    AXP_REG(0x33, "charge_ctrl1", "REG33 (Charging Control 1)", axp_fields_reg33),
+    AXP_REG(0x34, "charge_ctrl2", "REG34 (Charging Control 2)", axp_fields_reg34),
+    AXP_REG(0x35, "charge_ctrl3", "REG35 (Charging Control 3)", axp_fields_reg35),
+    AXP_ADC(0x78, 4, axp_fields_vbat),
+    AXP_ADC(0x7A, 5, axp_fields_ichg),
+    AXP_ADC(0x7C, 5, axp_fields_idis),
+    AXP_ADC(0x56, 4, axp_fields_temp),
+    AXP_REG(0x82, "adc_enable", "REG82 (ADC Enable 1)", axp_fields_reg82),
+    AXP_REG(0x84, "adc_rate", "REG84 (ADC Sample Rate, TS Pin)", axp_fields_reg84),
+    AXP_REG(0xB8, "fuel_gauge", "REG B8 (Fuel Gauge Control)", axp_fields_regb8),
+    { 0xE0, 2, 0, "capacity", "REG E0/E1 (Battery Capacity)", axp_fields_rege0,
+      sizeof(axp_fields_rege0) / sizeof(axp_fields_rege0[0]) },
+    AXP_REG(0x48, "irq", "REG 48h (IRQ Status 1)", axp_fields_reg48),
+    AXP_REG(0x49, "irq", "REG 49h (IRQ Status 2)", axp_fields_reg49),
+    AXP_REG(0x4A, "irq", "REG 4Ah (IRQ Status 3)", axp_fields_reg4a),
+    AXP_REG(0x4B, "irq", "REG 4Bh (IRQ Status 4)", axp_fields_reg4b),
+    AXP_REG(0x4C, "irq", "REG 4Ch (IRQ Status 5)", axp_fields_reg4c),
+};
+
+_Static_assert(sizeof(axp_decode_table) / sizeof(axp_decode_table[0]) == AXP_DECODE_COUNT,
+               "AXP_DECODE_COUNT must match axp_decode_table");
+#endif // AXP_EXTERN_DATA
+
+// ==========================
+// Ausgabepuffer
+// ==========================
+
+typedef struct {
+    char* buf;
+    size_t len;
+    size_t cap;
+} axp_out;
+
+AXP_API void axp_out_mem(axp_out* o, const char* s, size_t n) {
+    if (n > o->cap - o->len)
+        n = o->cap - o->len;
+    memcpy(o->buf + o->len, s, n);
+    o->len += n;
+}
+
+AXP_API void axp_out_str(axp_out* o, const char* s) {
+    axp_out_mem(o, s, strlen(s));
+}
+
+AXP_API void axp_out_char(axp_out* o, char c) {
+    if (o->len < o->cap)
+        o->buf[o->len++] = c;
+}
+
+AXP_API void axp_out_pad(axp_out* o, size_t start, size_t width) {
+    while (o->len - start < width && o->len < o->cap)
+        o->buf[o->len++] = ' ';
+}
+
+AXP_API void axp_out_uint(axp_out* o, uint64_t v) {
+    char tmp[20];
+    int n = 0;
+    do {
+        tmp[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v);
+    while (n)
+        axp_out_char(o, tmp[--n]);
+}
+
+AXP_API void axp_out_hex(axp_out* o, uint32_t v, int digits) {
+    static const char hex[] = "0123456789ABCDEF";
+    axp_out_str(o, "0x");
+    for (int i = digits - 1; i >= 0; --i)
+        axp_out_char(o, hex[(v >> (4 * i)) & 0xF]);
+}
+
+// Fixed-point value with `decimals` implied decimal places
+AXP_API void axp_out_fixed(axp_out* o, int64_t v, int decimals) {
+    if (v < 0) {
+        axp_out_char(o, '-');
+        v = -v;
+    }
+    uint64_t div = 1;
+    for (int i = 0; i < decimals; ++i)
+        div *= 10;
+    axp_out_uint(o, (uint64_t)v / div);
+    if (decimals) {
+        axp_out_char(o, '.');
+        uint64_t frac = (uint64_t)v % div;
+        for (uint64_t d = div / 10; d; d /= 10) {
+            axp_out_char(o, '0' + frac / d);
+            frac %= d;
+        }
+    }
+}
+
+AXP_API int axp_out_flush(axp_out* o, int fd) {
+    size_t off = 0;
+    while (off < o->len) {
+        ssize_t n = write(fd, o->buf + off, o->len - off);
+        if (n <= 0)
+            return -1;
+        off += n;
+    }
+    o->len = 0;
+    return 0;
+}
+
+// ==========================
+// Generischer Decoder
+// ==========================
+
+// Combined raw value of a descriptor's register(s)
+AXP_API uint32_t axp_desc_raw(const axp_reg_desc* d, const uint8_t* regs) {
+    if (d->nregs == 1)
+        return regs[d->reg];
+    uint8_t hi = regs[d->reg], lo = regs[d->reg + 1];
+    if (d->split)
+        return ((uint32_t)hi << d->split) | (lo & ((1u << d->split) - 1));
+    return ((uint32_t)hi << 8) | lo;
+}
+
+AXP_API uint32_t axp_field_raw(const axp_field* f, uint32_t word) {
+    return (word >> f->shift) & ((1u << f->width) - 1);
+}
+
+AXP_API int64_t axp_field_scaled(const axp_field* f, uint32_t raw) {
+    return (int64_t)raw * f->mul + f->offset;
+}
+
+#define AXP_LABEL_WIDTH 42
+
+AXP_API void axp_render_field(axp_out* o, const axp_field* f, uint32_t word, bool indent) {
+    uint32_t raw = axp_field_raw(f, word);
+    if (f->kind == AXP_F_FLAG) {
+        if (raw) {
+            axp_out_str(o, "  - ");
+            axp_out_str(o, f->name);
+            axp_out_char(o, '\n');
+        }
+        return;
+    }
+
+    size_t start = o->len;
+    if (indent)
+        axp_out_str(o, "  - ");
+    axp_out_str(o, f->name);
+    axp_out_pad(o, start, AXP_LABEL_WIDTH);
+    axp_out_str(o, ": ");
+
+    switch (f->kind) {
+    case AXP_F_BOOL:
+    case AXP_F_ENUM:
+        axp_out_str(o, f->labels[raw]);
+        break;
+    case AXP_F_LOOKUP:
+        if (f->values[raw] < 0) {
+            axp_out_str(o, "Invalid/Reserved");
+        } else {
+            axp_out_uint(o, f->values[raw]);
+            axp_out_char(o, ' ');
+            axp_out_str(o, f->unit);
+        }
+        break;
+    case AXP_F_SCALED:
+        axp_out_fixed(o, axp_field_scaled(f, raw), f->decimals);
+        axp_out_char(o, ' ');
+        axp_out_str(o, f->unit);
+        axp_out_str(o, " (RAW: ");
+        axp_out_hex(o, raw, (f->width + 3) / 4);
+        axp_out_char(o, ')');
+        break;
+    case AXP_F_HEX:
+        axp_out_hex(o, raw, (f->width + 3) / 4);
+        break;
+    }
+    axp_out_char(o, '\n');
+}
+
+AXP_API void axp_render_desc(axp_out* o, const axp_reg_desc* d, const uint8_t* regs) {
+    uint32_t word = axp_desc_raw(d, regs);
+    if (d->title) {
+        axp_out_str(o, d->title);
+        axp_out_str(o, ": ");
+        axp_out_hex(o, d->nregs == 2 ? ((uint32_t)regs[d->reg] << 8) | regs[d->reg + 1] : regs[d->reg],
+                    2 * d->nregs);
+        axp_out_char(o, '\n');
+    }
+    for (size_t i = 0; i < d->nfields; ++i)
+        axp_render_field(o, &d->fields[i], word, d->title != NULL);
+}
+
+// Render every table entry whose first register lies in [first, last] and
+// whose registers are valid in the snapshot. Returns the number rendered.
+AXP_API size_t axp_render_range(axp_out* o, const axp_snapshot* snap, uint8_t first, uint8_t last) {
+    size_t n = 0;
+    for (size_t i = 0; i < AXP_DECODE_COUNT; ++i) {
+        const axp_reg_desc* d = &axp_decode_table[i];
+        if (d->reg < first || d->reg > last || !axp_snapshot_has(snap, d->reg, d->nregs))
+            continue;
+        axp_render_desc(o, d, snap->reg);
+        n++;
+    }
+    return n;
+}
+
+// ==========================
+// Maschinenlesbare Ausgabe
+// ==========================
+// JSON (one object per record), CSV (header row + value rows) and kv
+// (key=value per line). Keys are "<group>.<key>" or just "<key>" for the
+// ADC values, e.g. "battery_voltage", "irq.pek_short". Numbers use the same
+// fixed-point values as the text output.
+
+typedef enum {
+    AXP_FMT_TEXT,
+    AXP_FMT_JSON,
+    AXP_FMT_CSV,
+    AXP_FMT_KV,
+} axp_format;
+
+AXP_API int axp_parse_format(const char* s) {
+    if (strcmp(s, "text") == 0) return AXP_FMT_TEXT;
+    if (strcmp(s, "json") == 0) return AXP_FMT_JSON;
+    if (strcmp(s, "csv") == 0)  return AXP_FMT_CSV;
+    if (strcmp(s, "kv") == 0)   return AXP_FMT_KV;
+    return -1;
+}
+
+typedef struct {
+    axp_out* o;
+    uint8_t fmt;
+    bool header;    // CSV: Kopfzeile statt Werte
+    size_t n;       // bisher ausgegebene Schluessel
+} axp_rec;
+
+AXP_API void axp_rec_begin(axp_rec* r, axp_out* o, uint8_t fmt, bool header) {
+    r->o = o;
+    r->fmt = fmt;
+    r->header = header;
+    r->n = 0;
+    if (fmt == AXP_FMT_JSON)
+        axp_out_char(o, '{');
+}
+
+AXP_API void axp_rec_end(axp_rec* r) {
+    if (r->fmt == AXP_FMT_JSON)
+        axp_out_char(r->o, '}');
+    axp_out_char(r->o, '\n');
+}
+
+// Emit the key (and separator). Returns false if no value must follow
+// (CSV header row).
+AXP_API bool axp_rec_key(axp_rec* r, const char* group, const char* key) {
+    axp_out* o = r->o;
+    if (r->n++) {
+        if (r->fmt == AXP_FMT_KV)
+            axp_out_char(o, '\n');
+        else
+            axp_out_char(o, ',');
+    }
+    if (r->fmt == AXP_FMT_CSV && !r->header)
+        return true;
+
+    if (r->fmt == AXP_FMT_JSON)
+        axp_out_char(o, '"');
+    if (group) {
+        axp_out_str(o, group);
+        axp_out_char(o, '.');
+    }
+    axp_out_str(o, key);
+    if (r->fmt == AXP_FMT_JSON)
+        axp_out_str(o, "\":");
+    else if (r->fmt == AXP_FMT_KV)
+        axp_out_char(o, '=');
+    return r->fmt != AXP_FMT_CSV;
+}
+
+AXP_API void axp_rec_null(axp_rec* r) {
+    if (r->fmt == AXP_FMT_JSON)
+        axp_out_str(r->o, "null");
+}
+
+AXP_API void axp_rec_bool(axp_rec* r, bool v) {
+    if (r->fmt == AXP_FMT_JSON)
+        axp_out_str(r->o, v ? "true" : "false");
+    else
+        axp_out_char(r->o, v ? '1' : '0');
+}
+
+AXP_API void axp_rec_str(axp_rec* r, const char* v) {
+    axp_out_char(r->o, '"');
+    axp_out_str(r->o, v);
+    axp_out_char(r->o, '"');
+}
+
+AXP_API void axp_rec_field(axp_rec* r, const axp_field* f, uint32_t word) {
+    uint32_t raw = axp_field_raw(f, word);
+    switch (f->kind) {
+    case AXP_F_BOOL:
+    case AXP_F_FLAG:
+        axp_rec_bool(r, raw);
+        break;
+    case AXP_F_ENUM:
+        axp_rec_str(r, f->labels[raw]);
+        break;
+    case AXP_F_LOOKUP:
+        if (f->values[raw] < 0)
+            axp_rec_null(r);
+        else
+            axp_out_uint(r->o, f->values[raw]);
+        break;
+    case AXP_F_SCALED:
+        axp_out_fixed(r->o, axp_field_scaled(f, raw), f->decimals);
+        break;
+    case AXP_F_HEX:
+        axp_out_uint(r->o, raw);
+        break;
+    }
+}
+
+// All decoded fields of table entries in [first, last]. Entries whose
+// registers are not valid are emitted as null/empty so CSV columns stay
+// stable.
+AXP_API void axp_rec_decoded(axp_rec* r, const axp_snapshot* snap, uint8_t first, uint8_t last) {
+    for (size_t i = 0; i < AXP_DECODE_COUNT; ++i) {
+        const axp_reg_desc* d = &axp_decode_table[i];
+        if (d->reg < first || d->reg > last)
+            continue;
+        bool valid = axp_snapshot_has(snap, d->reg, d->nregs);
+        uint32_t word = valid ? axp_desc_raw(d, snap->reg) : 0;
+        for (size_t k = 0; k < d->nfields; ++k) {
+            if (!axp_rec_key(r, d->group, d->fields[k].key))
+                continue;
+            if (valid)
+                axp_rec_field(r, &d->fields[k], word);
+            else
+                axp_rec_null(r);
+        }
+    }
+}
+
+// Raw register values as "reg.0xNN"
+AXP_API void axp_rec_registers(axp_rec* r, const axp_snapshot* snap, const uint8_t* addrs, size_t count) {
+    char key[5] = "0x00";
+    static const char hex[] = "0123456789ABCDEF";
+    for (size_t i = 0; i < count; ++i) {
+        key[2] = hex[addrs[i] >> 4];
+        key[3] = hex[addrs[i] & 0xF];
+        if (!axp_rec_key(r, "reg", key))
+            continue;
+        if (axp_snapshot_is_valid(snap, addrs[i]))
+            axp_out_uint(r->o, snap->reg[addrs[i]]);
+        else
+            axp_rec_null(r);
+    }
+}
+
+// ==========================
+// Aenderungen (Watch)
+// ==========================
+// Delta output for a changed-register bitmap from axp_snapshot_diff():
+// only table entries with a changed register, and of those only the fields
+// whose value differs, are emitted.
+
+AXP_API bool axp_desc_changed(const axp_reg_desc* d, const uint32_t* changed) {
+    for (unsigned r = d->reg; r < (unsigned)d->reg + d->nregs; ++r)
+        if (axp_bitmap_test(changed, r))
+            return true;
+    return false;
+}
+
+// Collect the fields matching `key`, "<group>.<key>" or just "<key>". A
+// key without group that names an ungrouped field exactly is that field;
+// otherwise it matches the field of that name in every group. Returns the
+// number of matches, stores the first one and lists their full keys in
+// `names` (" or " separated).
+AXP_API size_t axp_decode_match(const char* key, const axp_reg_desc** desc, const axp_field** field,
+                                char* names, size_t len) {
+    const char* dot = strchr(key, '.');
+    size_t n = 0, used = 0;
+    *desc = NULL;
+    *field = NULL;
+    if (len)
+        names[0] = '\0';
+    // Erst die Felder ohne Gruppe: deren Schluessel ist schon der volle Name
+    for (int grouped = dot != NULL; grouped < 2 && n == 0; ++grouped) {
+        for (size_t i = 0; i < AXP_DECODE_COUNT; ++i) {
+            const axp_reg_desc* d = &axp_decode_table[i];
+            const char* k = key;
+            if ((d->group != NULL) != grouped)
+                continue;
+            if (dot && (strlen(d->group) != (size_t)(dot - key) || strncmp(d->group, key, dot - key) != 0))
+                continue;
+            if (dot)
+                k = dot + 1;
+            for (size_t f = 0; f < d->nfields; ++f) {
+                if (strcmp(d->fields[f].key, k) != 0)
+                    continue;
+                if (n++ == 0) {
+                    *desc = d;
+                    *field = &d->fields[f];
+                }
+                if (used < len) {
+                    int w = snprintf(names + used, len - used, "%s%s%s%s", n > 1 ? " or " : "",
+                                     d->group ? d->group : "", d->group ? "." : "", k);
+                    used += w > 0 ? (size_t)w : 0;
+                }
+            }
+        }
+    }
+    return n;
+}
+
+// Look up a field by its machine key, "<group>.<key>" or just "<key>"
+// ("irq.pek_long", "pek_long", "battery_voltage"). Returns the table entry
+// and stores the field, or NULL if no field or more than one has that key;
+// axp_decode_explain() tells the two apart for the error message.
+AXP_API const axp_reg_desc* axp_decode_find(const char* key, const axp_field** field) {
+    const axp_reg_desc* d = NULL;
+    if (axp_decode_match(key, &d, field, NULL, 0) == 1)
+        return d;
+    *field = NULL;
+    return NULL;
+}
+
+// Print why axp_decode_find() failed for `key`: `what` followed by the key
+// and, for an unqualified key found in several groups, the qualified names
+AXP_API void axp_decode_explain(FILE* out, const char* what, const char* key) {
+    const axp_reg_desc* d;
+    const axp_field* f;
+    char names[256];
+    if (axp_decode_match(key, &d, &f, names, sizeof(names)) > 1)
+        fprintf(out, "Ambiguous %s: %s (qualify as %s)\n", what, key, names);
+    else
+        fprintf(out, "Unknown %s: %s\n", what, key);
+}
+
+// True if some table entry decodes `reg`
+AXP_API bool axp_decode_covers(uint8_t reg) {
+    for (size_t i = 0; i < AXP_DECODE_COUNT; ++i) {
+        const axp_reg_desc* d = &axp_decode_table[i];
+        if (reg >= d->reg && reg < d->reg + d->nregs)
+            return true;
+    }
+    return false;
+}
+
+// Text: "<title>: 0xOLD -> 0xNEW" plus the changed fields with their new
+// value. Returns the number of entries rendered.
+AXP_API size_t axp_render_changes(axp_out* o, const axp_snapshot* old, const axp_snapshot* cur,
+                                  const uint32_t* changed) {
+    size_t n = 0;
+    for (size_t i = 0; i < AXP_DECODE_COUNT; ++i) {
+        const axp_reg_desc* d = &axp_decode_table[i];
+        if (!axp_desc_changed(d, changed) || !axp_snapshot_has(cur, d->reg, d->nregs))
+            continue;
+        bool had = axp_snapshot_has(old, d->reg, d->nregs);
+        uint32_t before = had ? axp_desc_raw(d, old->reg) : 0;
+        uint32_t now = axp_desc_raw(d, cur->reg);
+
+        if (d->title) {
+            axp_out_str(o, d->title);
+            axp_out_str(o, ": ");
+            if (had) {
+                axp_out_hex(o, d->nregs == 2 ? ((uint32_t)old->reg[d->reg] << 8) | old->reg[d->reg + 1]
+                                             : old->reg[d->reg], 2 * d->nregs);
+                axp_out_str(o, " -> ");
+            }
+            axp_out_hex(o, d->nregs == 2 ? ((uint32_t)cur->reg[d->reg] << 8) | cur->reg[d->reg + 1]
+                                         : cur->reg[d->reg], 2 * d->nregs);
+            axp_out_char(o, '\n');
+        }
+        for (size_t k = 0; k < d->nfields; ++k) {
+            const axp_field* f = &d->fields[k];
+            if (had && axp_field_raw(f, before) == axp_field_raw(f, now))
+                continue;
+            if (f->kind == AXP_F_FLAG && !axp_field_raw(f, now)) {
+                axp_out_str(o, "  - ");
+                axp_out_str(o, f->name);
+                axp_out_str(o, " (cleared)\n");
+                continue;
+            }
+            axp_render_field(o, f, now, d->title != NULL);
+        }
+        n++;
+    }
+    return n;
+}
+
+// Machine formats: changed fields, then the changed raw registers of
+// `addrs` as "reg.0xNN".
+AXP_API void axp_rec_changes(axp_rec* r, const axp_snapshot* old, const axp_snapshot* cur,
+                             const uint32_t* changed, const uint8_t* addrs, size_t count) {
+    for (size_t i = 0; i < AXP_DECODE_COUNT; ++i) {
+        const axp_reg_desc* d = &axp_decode_table[i];
+        if (!axp_desc_changed(d, changed) || !axp_snapshot_has(cur, d->reg, d->nregs))
+            continue;
+        bool had = axp_snapshot_has(old, d->reg, d->nregs);
+        uint32_t before = had ? axp_desc_raw(d, old->reg) : 0;
+        uint32_t now = axp_desc_raw(d, cur->reg);
+        for (size_t k = 0; k < d->nfields; ++k) {
+            const axp_field* f = &d->fields[k];
+            if (had && axp_field_raw(f, before) == axp_field_raw(f, now))
+                continue;
+            if (axp_rec_key(r, d->group, f->key))
+                axp_rec_field(r, f, now);
+        }
+    }
+
+    char key[5] = "0x00";
+    static const char hex[] = "0123456789ABCDEF";
+    for (size_t i = 0; i < count; ++i) {
+        if (!axp_bitmap_test(changed, addrs[i]))
+            continue;
+        key[2] = hex[addrs[i] >> 4];
+        key[3] = hex[addrs[i] & 0xF];
+        if (axp_rec_key(r, "reg", key))
+            axp_out_uint(r->o, cur->reg[addrs[i]]);
+    }
+}
+
+#endif // AXP223_DECODE_H
@@ -0,0 +1,208 @@
+#ifndef AXP223_ENERGY_H
+#define AXP223_ENERGY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// ==========================
+// Ladungs-/Energiezaehler
+// ==========================
+// Trapezoidal integration of the battery ADC samples into charge (nAh) and
+// energy (nWh) accumulators, separately for charging and discharging. All
+// arithmetic is 64-bit integer: each step adds (x0 + x1) * dt_ns to a
+// remainder and moves whole units into the accumulator, so nothing is lost
+// to rounding however long the daemon runs.
+//
+// The accumulators live in a small state file that is mmap'd shared: they
+// survive restarts, and clients read them directly (axplog_decode <file>)
+// under a sequence lock instead of streaming samples off the device.
+
+#define AXP_ENERGY_MAGIC    "AXPNRG1"
+#define AXP_ENERGY_VERSION  1
+
+// Samples further apart than this are not integrated (read errors, stalls)
+#define AXP_ENERGY_MAX_GAP_NS   (2ull * 1000000000ull)
+#define AXP_ENERGY_SYNC_NS      (10ull * 1000000000ull)
+
+// 1 nAh = 3.6e-6 C = 3.6e7 * (0.1 mA * 1 ns)
+#define AXP_ENERGY_DMA_NS_PER_NAH  36000000ll
+// 1 nWh = 3.6e-6 J = 3.6e9 * (1 uW * 1 ns)
+#define AXP_ENERGY_UW_NS_PER_NWH   3600000000ll
+
+enum {
+    AXP_ENERGY_IN,      // Laden
+    AXP_ENERGY_OUT,     // Entladen
+};
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t size;
+    _Atomic uint32_t seq;       // ungerade waehrend eines Updates
+    uint32_t reserved0;
+    int64_t charge_nah[2];      // AXP_ENERGY_IN / AXP_ENERGY_OUT
+    int64_t energy_nwh[2];
+    int64_t charge_rem[2];      // Reste in 2 * 0.1 mA * ns
+    int64_t energy_rem[2];      // Reste in 2 * uW * ns
+    uint64_t integrated_ns;     // abgedeckte Zeit
+    uint64_t samples;
+    uint64_t gaps;              // nicht integrierte Luecken
+    uint64_t updated_unix_ns;   // CLOCK_REALTIME der letzten Aenderung
+    uint8_t reserved[40];
+} axp_energy_state;
+
+_Static_assert(sizeof(axp_energy_state) == 160, "energy state must be 160 bytes");
+
+// One battery sample in the ADC's fixed-point units
+typedef struct {
+    uint64_t t_ns;              // CLOCK_MONOTONIC
+    int32_t dmv;                // 0.1 mV
+    int32_t chg_dma;            // 0.1 mA
+    int32_t dis_dma;
+} axp_energy_sample;
+
+typedef struct {
+    int fd;
+    axp_energy_state* st;
+    axp_energy_sample prev;
+    bool have_prev;             // Vorgaenger fuer das Trapez vorhanden
+    uint64_t last_sync_ns;
+} axp_energy;
+
+// Open or create the state file. An existing file keeps its accumulators;
+// a file that is not an energy state is refused rather than overwritten.
+static inline int axp_energy_open(axp_energy* e, const char* path) {
+    memset(e, 0, sizeof(*e));
+    e->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (e->fd < 0)
+        return -1;
+
+    struct stat st;
+    if (fstat(e->fd, &st) < 0)
+        goto fail;
+    bool fresh = st.st_size == 0;
+    if (!fresh && st.st_size != sizeof(axp_energy_state)) {
+        errno = EINVAL;
+        goto fail;
+    }
+    if (fresh && ftruncate(e->fd, sizeof(axp_energy_state)) < 0)
+        goto fail;
+
+    void* p = mmap(NULL, sizeof(axp_energy_state), PROT_READ | PROT_WRITE, MAP_SHARED, e->fd, 0);
+    if (p == MAP_FAILED)
+        goto fail;
+    e->st = p;
+
+    if (fresh) {
+        memcpy(e->st->magic, AXP_ENERGY_MAGIC, sizeof(AXP_ENERGY_MAGIC));
+        e->st->version = AXP_ENERGY_VERSION;
+        e->st->size = sizeof(axp_energy_state);
+    } else if (memcmp(e->st->magic, AXP_ENERGY_MAGIC, sizeof(AXP_ENERGY_MAGIC)) != 0 ||
+               e->st->version != AXP_ENERGY_VERSION) {
+        munmap(p, sizeof(axp_energy_state));
+        e->st = NULL;
+        errno = EINVAL;
+        goto fail;
+    }
+    // Ein Absturz mitten im Update hinterlaesst eine ungerade Sequenz
+    atomic_store(&e->st->seq, atomic_load(&e->st->seq) & ~1u);
+    return 0;
+
+fail:
+    close(e->fd);
+    e->fd = -1;
+    return -1;
+}
+
+static inline void axp_energy_step(int64_t* acc, int64_t* rem, int64_t sum, uint64_t dt_ns, int64_t unit) {
+    *rem += sum * (int64_t)dt_ns;
+    int64_t q = *rem / (2 * unit);
+    *acc += q;
+    *rem -= q * 2 * unit;
+}
+
+// Integrate from the previous sample to `s`. A missing sample (read error)
+// is passed as NULL and breaks the chain.
+static inline void axp_energy_add(axp_energy* e, const axp_energy_sample* s) {
+    if (!s) {
+        e->have_prev = false;
+        return;
+    }
+
+    axp_energy_state* st = e->st;
+    atomic_fetch_add_explicit(&st->seq, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    st->samples++;
+    if (e->have_prev) {
+        uint64_t dt = s->t_ns - e->prev.t_ns;
+        if (s->t_ns <= e->prev.t_ns || dt > AXP_ENERGY_MAX_GAP_NS) {
+            st->gaps++;
+        } else {
+            // 0.1 mV * 0.1 mA = 1e-8 W -> uW
+            int64_t p0_in = (int64_t)e->prev.dmv * e->prev.chg_dma / 100;
+            int64_t p1_in = (int64_t)s->dmv * s->chg_dma / 100;
+            int64_t p0_out = (int64_t)e->prev.dmv * e->prev.dis_dma / 100;
+            int64_t p1_out = (int64_t)s->dmv * s->dis_dma / 100;
+
+            axp_energy_step(&st->charge_nah[AXP_ENERGY_IN], &st->charge_rem[AXP_ENERGY_IN],
+                            e->prev.chg_dma + s->chg_dma, dt, AXP_ENERGY_DMA_NS_PER_NAH);
+            axp_energy_step(&st->charge_nah[AXP_ENERGY_OUT], &st->charge_rem[AXP_ENERGY_OUT],
+                            e->prev.dis_dma + s->dis_dma, dt, AXP_ENERGY_DMA_NS_PER_NAH);
+            axp_energy_step(&st->energy_nwh[AXP_ENERGY_IN], &st->energy_rem[AXP_ENERGY_IN],
+                            p0_in + p1_in, dt, AXP_ENERGY_UW_NS_PER_NWH);
+            axp_energy_step(&st->energy_nwh[AXP_ENERGY_OUT], &st->energy_rem[AXP_ENERGY_OUT],
+                            p0_out + p1_out, dt, AXP_ENERGY_UW_NS_PER_NWH);
+            st->integrated_ns += dt;
+        }
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    st->updated_unix_ns = (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+
+    atomic_thread_fence(memory_order_release);
+    atomic_fetch_add_explicit(&st->seq, 1, memory_order_relaxed);
+
+    e->prev = *s;
+    e->have_prev = true;
+
+    // Periodisch auf den Datentraeger, damit ein Stromausfall wenig kostet
+    if (s->t_ns - e->last_sync_ns >= AXP_ENERGY_SYNC_NS) {
+        msync(st, sizeof(*st), MS_ASYNC);
+        e->last_sync_ns = s->t_ns;
+    }
+}
+
+static inline void axp_energy_close(axp_energy* e) {
+    if (e->fd < 0)
+        return;
+    if (e->st) {
+        msync(e->st, sizeof(*e->st), MS_SYNC);
+        munmap(e->st, sizeof(*e->st));
+    }
+    close(e->fd);
+    e->fd = -1;
+}
+
+// Consistent copy of a state that a writer may be updating
+static inline void axp_energy_read(const axp_energy_state* st, axp_energy_state* out) {
+    for (;;) {
+        uint32_t seq = atomic_load_explicit((_Atomic uint32_t*)&st->seq, memory_order_acquire);
+        if (seq & 1)
+            continue;
+        memcpy(out, (const void*)st, sizeof(*out));
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit((_Atomic uint32_t*)&st->seq, memory_order_relaxed) == seq)
+            return;
+    }
+}
+
+#endif // AXP223_ENERGY_H
@@ -0,0 +1,789 @@
+#ifndef AXP223_I2C_H
+#define AXP223_I2C_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include "axp223_api.h"
+#include "axp223_sim.h"
+#include "axp223_proto.h"
+#include "axp223_metrics.h"
+
+// ==========================
+// I2C Transaktionsschicht
+// ==========================
+// Register reads go through the I2C_RDWR ioctl: the register-pointer write
+// and the data read are sent as one repeated-start message pair, and many
+// such pairs are packed into a single ioctl (one kernel round trip).
+//
+// The transfer itself is pluggable: a bus path of "sim" or "sim:opts"
+// selects the in-process AXP223 simulator (axp223_sim.h) instead of
+// /dev/i2c-N, so all tools run and can be benchmarked without hardware.
+// "axpd" or "axpd:/socket" sends the transfers to the resident server
+// (axpd.c), which answers reads from its register cache.
+//
+// With AXP_METRICS=<file> in the environment every transaction is counted
+// and timed into a shared metrics segment (axp223_metrics.h).
+//
+// Not every adapter can do I2C_RDWR. At open the adapter's I2C_FUNCS are
+// queried once and the fastest supported access path is chosen: I2C_RDWR
+// (many reads per ioctl), SMBus I2C block reads (32 bytes per ioctl) or
+// SMBus byte data (one register per ioctl). The SMBus paths translate the
+// same message lists, so callers do not change. AXP_I2C_ACCESS=rdwr|block|
+// byte in the environment selects a slower path for testing.
+//
+// Failed transactions are classified by errno. Transient ones (NAK,
+// arbitration lost) are retried with jittered exponential backoff, within a
+// retry budget and a per-operation deadline. On a real adapter a run of
+// failed operations reopens the device file and bounds the kernel's
+// I2C_TIMEOUT/I2C_RETRIES to the deadline; adapter_timeout=1 does the
+// latter already at open. Neither recovers a wedged bus.
+// AXP_I2C_POLICY=deadline=<ms>,retries=<n>,backoff=<us>,reopen=<n>,
+// adapter_timeout=<0|1> overrides the defaults; reopen=0 never reopens.
+
+// Each register read needs two messages (pointer write + data read)
+#define AXP_I2C_MSGS_PER_READ 2
+#define AXP_I2C_READS_PER_XFER (I2C_RDWR_IOCTL_MAX_MSGS / AXP_I2C_MSGS_PER_READ)
+
+typedef struct axp_i2c_dev axp_i2c_dev;
+
+// Zugriffspfad, vom schnellsten zum langsamsten
+enum {
+    AXP_I2C_ACCESS_RDWR,
+    AXP_I2C_ACCESS_BLOCK,   // SMBus I2C block read, 32 Bytes pro ioctl
+    AXP_I2C_ACCESS_BYTE,    // SMBus byte data, ein Register pro ioctl
+    AXP_I2C_ACCESS_SERVER,  // axpd
+};
+
+#define AXP_I2C_ACCESS_ENV  "AXP_I2C_ACCESS"
+#define AXP_I2C_BLOCK_MAX   I2C_SMBUS_BLOCK_MAX
+#define AXP_I2C_POLICY_ENV  "AXP_I2C_POLICY"
+
+typedef struct {
+    uint32_t deadline_ms;   // Obergrenze pro Operation inkl. Wiederholungen
+    uint32_t retries;       // Wiederholungen bei transienten Fehlern
+    uint32_t backoff_us;    // erste Wartezeit, je Versuch verdoppelt, mit Jitter
+    uint32_t reopen_after;  // fehlgeschlagene Operationen in Folge bis Reopen, 0 = nie
+    uint32_t adapter_timeout; // I2C_TIMEOUT/I2C_RETRIES schon beim Oeffnen setzen
+} axp_i2c_policy;
+
+#define AXP_I2C_POLICY_DEFAULT { 100, 2, 500, 3, 0 }
+
+typedef struct {
+    uint64_t retries;       // wiederholte Versuche
+    uint64_t failures;      // endgueltig fehlgeschlagene Operationen
+    uint64_t deadline_hits; // Wiederholung wegen der Deadline abgebrochen
+    uint64_t reopens;       // /dev/i2c-N neu geoeffnet
+} axp_i2c_counters;
+
+struct axp_i2c_dev {
+    int fd;
+    uint16_t addr;
+    // Returns nmsgs on success, -1 with errno set otherwise
+    int (*xfer)(axp_i2c_dev* dev, struct i2c_msg* msgs, unsigned nmsgs);
+    axp_sim* sim;
+    uint8_t ptr;    // register pointer, tracked for the axpd and SMBus backends
+    axp_metrics* metrics;
+    uint8_t access;
+    unsigned long funcs;    // I2C_FUNCS des Adapters
+    int slave;              // per I2C_SLAVE gesetzte Adresse, -1 = keine
+    // One SMBus transfer (I2C_SMBUS semantics) on the device or the simulator
+    int (*smbus)(axp_i2c_dev* dev, uint16_t addr, uint8_t rw, uint8_t cmd, uint32_t size,
+                 union i2c_smbus_data* data);
+    axp_i2c_policy policy;
+    axp_i2c_counters counters;
+    uint32_t fail_streak;   // fehlgeschlagene Operationen in Folge
+    int last_err;           // errno der letzten fehlgeschlagenen Operation, 0 = ok
+    unsigned jitter_seed;
+    char path[128];         // fuer das Wiederoeffnen, leer = nicht moeglich
+};
+
+AXP_API int axp_i2c_xfer_dev(axp_i2c_dev* dev, struct i2c_msg* msgs, unsigned nmsgs) {
+    struct i2c_rdwr_ioctl_data xfer = { .msgs = msgs, .nmsgs = nmsgs };
+    return ioctl(dev->fd, I2C_RDWR, &xfer);
+}
+
+AXP_API int axp_i2c_xfer_sim(axp_i2c_dev* dev, struct i2c_msg* msgs, unsigned nmsgs) {
+    return axp_sim_xfer(dev->sim, msgs, nmsgs);
+}
+
+AXP_API int axp_i2c_xfer_srv(axp_i2c_dev* dev, struct i2c_msg* msgs, unsigned nmsgs) {
+    return axp_proto_xfer(dev->fd, &dev->ptr, msgs, nmsgs);
+}
+
+AXP_API int axp_i2c_xfer_once(axp_i2c_dev* dev, struct i2c_msg* msgs, unsigned nmsgs) {
+    if (!dev->metrics)
+        return dev->xfer(dev, msgs, nmsgs);
+
+    uint64_t t0 = axp_metrics_now();
+    errno = 0;
+    int ret = dev->xfer(dev, msgs, nmsgs);
+    int err = ret == (int)nmsgs ? 0 : (errno ? errno : EIO);
+    axp_metrics_record(dev->metrics, msgs, nmsgs, err, axp_metrics_now() - t0);
+    if (err)
+        errno = err;
+    return ret;
+}
+
+// ==========================
+// SMBus-Zugriff
+// ==========================
+
+AXP_API int axp_i2c_smbus_dev(axp_i2c_dev* dev, uint16_t addr, uint8_t rw, uint8_t cmd,
+                              uint32_t size, union i2c_smbus_data* data) {
+    if (dev->slave != addr) {
+        // Wie I2C_RDWR auch an Adressen, die ein Kerneltreiber belegt
+        if (ioctl(dev->fd, I2C_SLAVE, addr) < 0 &&
+            (errno != EBUSY || ioctl(dev->fd, I2C_SLAVE_FORCE, addr) < 0))
+            return -1;
+        dev->slave = addr;
+    }
+    struct i2c_smbus_ioctl_data args = { .read_write = rw, .command = cmd, .size = size, .data = data };
+    return ioctl(dev->fd, I2C_SMBUS, &args);
+}
+
+// The same SMBus transfer as a message list for the simulator
+AXP_API int axp_i2c_smbus_sim(axp_i2c_dev* dev, uint16_t addr, uint8_t rw, uint8_t cmd,
+                              uint32_t size, union i2c_smbus_data* data) {
+    uint8_t buf[1 + AXP_I2C_BLOCK_MAX];
+    struct i2c_msg msgs[2];
+    unsigned n = 1;
+    buf[0] = cmd;
+    msgs[0] = (struct i2c_msg){ .addr = addr, .flags = 0, .len = 1, .buf = buf };
+
+    uint16_t len = size == I2C_SMBUS_BYTE_DATA ? 1 : data->block[0];
+    uint8_t* payload = size == I2C_SMBUS_BYTE_DATA ? &data->byte : &data->block[1];
+    if (rw == I2C_SMBUS_READ) {
+        msgs[n++] = (struct i2c_msg){ .addr = addr, .flags = I2C_M_RD, .len = len, .buf = payload };
+    } else {
+        memcpy(buf + 1, payload, len);
+        msgs[0].len = 1 + len;
+    }
+    return axp_sim_xfer(dev->sim, msgs, n) == (int)n ? 0 : -1;
+}
+
+// Read `len` bytes from `reg` with the widest SMBus read the path allows
+AXP_API int axp_i2c_smbus_read(axp_i2c_dev* dev, uint16_t addr, uint8_t reg, uint8_t* buf, uint16_t len) {
+    union i2c_smbus_data data;
+    while (len > 0) {
+        if (dev->access == AXP_I2C_ACCESS_BLOCK && len > 1) {
+            uint8_t n = len > AXP_I2C_BLOCK_MAX ? AXP_I2C_BLOCK_MAX : len;
+            data.block[0] = n;
+            if (dev->smbus(dev, addr, I2C_SMBUS_READ, reg, I2C_SMBUS_I2C_BLOCK_DATA, &data) < 0)
+                return -1;
+            memcpy(buf, &data.block[1], n);
+            reg += n, buf += n, len -= n;
+        } else {
+            if (dev->smbus(dev, addr, I2C_SMBUS_READ, reg, I2C_SMBUS_BYTE_DATA, &data) < 0)
+                return -1;
+            *buf++ = data.byte;
+            reg++, len--;
+        }
+    }
+    return 0;
+}
+
+AXP_API int axp_i2c_smbus_write(axp_i2c_dev* dev, uint16_t addr, uint8_t reg, const uint8_t* buf,
+                                uint16_t len) {
+    union i2c_smbus_data data;
+    bool block = len > 1 && (dev->funcs & I2C_FUNC_SMBUS_WRITE_I2C_BLOCK) &&
+                 dev->access == AXP_I2C_ACCESS_BLOCK;
+    while (len > 0) {
+        uint8_t n = block ? (len > AXP_I2C_BLOCK_MAX ? AXP_I2C_BLOCK_MAX : len) : 1;
+        uint32_t size = block ? I2C_SMBUS_I2C_BLOCK_DATA : I2C_SMBUS_BYTE_DATA;
+        if (block) {
+            data.block[0] = n;
+            memcpy(&data.block[1], buf, n);
+        } else {
+            data.byte = *buf;
+        }
+        if (dev->smbus(dev, addr, I2C_SMBUS_WRITE, reg, size, &data) < 0)
+            return -1;
+        reg += n, buf += n, len -= n;
+    }
+    return 0;
+}
+
+// Translate an I2C_RDWR message list: pointer write + read becomes SMBus
+// reads from that register, a write with data becomes SMBus writes. Unlike
+// I2C_RDWR the list is not one bus transaction; each SMBus transfer is.
+AXP_API int axp_i2c_xfer_smbus(axp_i2c_dev* dev, struct i2c_msg* msgs, unsigned nmsgs) {
+    for (unsigned i = 0; i < nmsgs; ++i) {
+        struct i2c_msg* m = &msgs[i];
+        if (m->flags & I2C_M_RD) {
+            if (axp_i2c_smbus_read(dev, m->addr, dev->ptr, m->buf, m->len) < 0)
+                return -1;
+            dev->ptr += m->len;
+        } else if (m->len > 0) {
+            dev->ptr = m->buf[0];
+            if (m->len > 1) {
+                if (axp_i2c_smbus_write(dev, m->addr, dev->ptr, m->buf + 1, m->len - 1) < 0)
+                    return -1;
+                dev->ptr += m->len - 1;
+            }
+        }
+    }
+    return nmsgs;
+}
+
+AXP_API const char* axp_i2c_access_name(const axp_i2c_dev* dev) {
+    static const char* const names[] = { "i2c-rdwr", "smbus-i2c-block", "smbus-byte", "axpd" };
+    return names[dev->access];
+}
+
+// Pick the fastest path the adapter supports (or a slower one requested
+// via AXP_I2C_ACCESS). Returns -1 with EOPNOTSUPP if there is none.
+AXP_API int axp_i2c_select_access(axp_i2c_dev* dev) {
+    if (dev->funcs & I2C_FUNC_I2C)
+        dev->access = AXP_I2C_ACCESS_RDWR;
+    else if ((dev->funcs & I2C_FUNC_SMBUS_READ_I2C_BLOCK) && (dev->funcs & I2C_FUNC_SMBUS_WRITE_BYTE_DATA))
+        dev->access = AXP_I2C_ACCESS_BLOCK;
+    else if ((dev->funcs & I2C_FUNC_SMBUS_BYTE_DATA) == I2C_FUNC_SMBUS_BYTE_DATA)
+        dev->access = AXP_I2C_ACCESS_BYTE;
+    else {
+        errno = EOPNOTSUPP;
+        return -1;
+    }
+
+    const char* want = getenv(AXP_I2C_ACCESS_ENV);
+    if (want && *want) {
+        int w = strcmp(want, "rdwr") == 0  ? AXP_I2C_ACCESS_RDWR :
+                strcmp(want, "block") == 0 ? AXP_I2C_ACCESS_BLOCK :
+                strcmp(want, "byte") == 0  ? AXP_I2C_ACCESS_BYTE : -1;
+        if (w < 0)
+            fprintf(stderr, "Ignoring unknown %s=%s\n", AXP_I2C_ACCESS_ENV, want);
+        else if (w < dev->access)
+            fprintf(stderr, "%s=%s not supported by the adapter, using %s\n", AXP_I2C_ACCESS_ENV, want,
+                    axp_i2c_access_name(dev));
+        else
+            dev->access = w;
+    }
+    if (dev->access != AXP_I2C_ACCESS_RDWR)
+        dev->xfer = axp_i2c_xfer_smbus;
+    return 0;
+}
+
+// Planner gap for this path: with one SMBus transfer per byte, filler
+// bytes cost as much as wanted ones, so spans are not merged
+AXP_API unsigned axp_i2c_plan_gap(const axp_i2c_dev* dev, unsigned gap) {
+    return dev->access == AXP_I2C_ACCESS_BYTE ? 0 : gap;
+}
+
+// ==========================
+// Fehlerbehandlung
+// ==========================
+
+// NAK and lost arbitration clear up by themselves; a timeout means a
+// wedged bus, and ENXIO/other errors will not change on a retry
+AXP_API bool axp_i2c_transient(int err) {
+    int cls = axp_metrics_err_class(err);
+    return cls == AXP_ERR_REMOTEIO || cls == AXP_ERR_AGAIN;
+}
+
+// Bound the kernel's own timeout and retries to the deadline, so a single
+// ioctl cannot block for the adapter's default timeout (often a second).
+// I2C_TIMEOUT and I2C_RETRIES are adapter settings, not per file: they
+// change the bus for every other user too, kernel drivers included, until
+// someone sets them again. So this only happens as an escalation in
+// axp_i2c_reopen(), or at open with adapter_timeout=1.
+AXP_API void axp_i2c_bound_adapter(axp_i2c_dev* dev) {
+    long timeout = dev->policy.deadline_ms / 10;  // Einheit 10 ms
+    if (ioctl(dev->fd, I2C_TIMEOUT, timeout > 0 ? timeout : 1) < 0 || ioctl(dev->fd, I2C_RETRIES, 1) < 0)
+        perror("Set adapter timeout failed");
+}
+
+// Reopen /dev/i2c-N. This only gives us a fresh file: it does not clock SCL
+// to release a slave holding SDA and does not reset the controller, so a
+// wedged bus stays wedged. It helps where the old descriptor is stuck in
+// a bad state, and the failure streak is logged either way.
+AXP_API int axp_i2c_reopen(axp_i2c_dev* dev) {
+    if (!dev->path[0])
+        return -1;
+    int fd = open(dev->path, O_RDWR);
+    if (fd < 0)
+        return -1;
+    close(dev->fd);
+    dev->fd = fd;
+    dev->slave = -1;
+    axp_i2c_bound_adapter(dev);
+    dev->counters.reopens++;
+    fprintf(stderr, "%s: reopened after %u failed operations (%s); the bus itself is not reset\n",
+            dev->path, dev->fail_streak, strerror(dev->last_err));
+    dev->fail_streak = 0;
+    return 0;
+}
+
+// One operation under the policy: retries transient errors with backoff
+// until the retry budget or the deadline runs out, and after repeated
+// failures reopens the device with axp_i2c_reopen() for one more attempt.
+AXP_API int axp_i2c_xfer(axp_i2c_dev* dev, struct i2c_msg* msgs, unsigned nmsgs) {
+    const axp_i2c_policy* p = &dev->policy;
+    uint64_t start = axp_metrics_now(), deadline = start + (uint64_t)p->deadline_ms * 1000000ull;
+    bool reopened = false;
+
+    for (uint32_t attempt = 0;; ++attempt) {
+        errno = 0;
+        int ret = axp_i2c_xfer_once(dev, msgs, nmsgs);
+        if (ret == (int)nmsgs) {
+            dev->fail_streak = 0;
+            dev->last_err = 0;
+            return ret;
+        }
+        int err = errno ? errno : EIO;
+        dev->last_err = err;
+
+        uint64_t delay_ns = 0;
+        bool again = axp_i2c_transient(err) && attempt < p->retries;
+        if (again) {
+            // Jitter auf [d/2, d], damit sich konkurrierende Master entzerren
+            uint64_t d = (uint64_t)p->backoff_us * 1000ull << (attempt < 16 ? attempt : 16);
+            delay_ns = d / 2 + (d ? (uint64_t)rand_r(&dev->jitter_seed) % (d / 2 + 1) : 0);
+            if (axp_metrics_now() + delay_ns > deadline) {
+                dev->counters.deadline_hits++;
+                again = false;
+            }
+        }
+        if (!again && !reopened && p->reopen_after && ++dev->fail_streak >= p->reopen_after &&
+            axp_i2c_reopen(dev) == 0 && axp_metrics_now() < deadline) {
+            reopened = true;
+            again = true;
+            delay_ns = 0;
+        }
+        if (!again) {
+            dev->counters.failures++;
+            errno = err;
+            return -1;
+        }
+
+        dev->counters.retries++;
+        struct timespec ts = { delay_ns / 1000000000ull, delay_ns % 1000000000ull };
+        while (nanosleep(&ts, &ts) < 0 && errno == EINTR)
+            ;
+    }
+}
+
+// One stderr line with the error handling counters, nothing if all are 0
+AXP_API void axp_i2c_report(const axp_i2c_dev* dev, const char* who) {
+    const axp_i2c_counters* c = &dev->counters;
+    if (c->retries || c->failures || c->deadline_hits || c->reopens)
+        fprintf(stderr, "%s: %llu retries, %llu failed operations, %llu deadline hits, %llu device reopens\n",
+                who, (unsigned long long)c->retries, (unsigned long long)c->failures,
+                (unsigned long long)c->deadline_hits, (unsigned long long)c->reopens);
+}
+
+// Policy from AXP_I2C_POLICY on top of the defaults
+AXP_API void axp_i2c_load_policy(axp_i2c_dev* dev) {
+    dev->policy = (axp_i2c_policy)AXP_I2C_POLICY_DEFAULT;
+    const char* spec = getenv(AXP_I2C_POLICY_ENV);
+    while (spec && *spec) {
+        char key[16];
+        size_t n = strcspn(spec, "=");
+        char* end;
+        unsigned long v = spec[n] == '=' ? strtoul(spec + n + 1, &end, 10) : 0;
+        if (n == 0 || n >= sizeof(key) || spec[n] != '=' || (*end && *end != ',')) {
+            fprintf(stderr, "Ignoring invalid %s\n", AXP_I2C_POLICY_ENV);
+            dev->policy = (axp_i2c_policy)AXP_I2C_POLICY_DEFAULT;
+            return;
+        }
+        memcpy(key, spec, n);
+        key[n] = '\0';
+        if (strcmp(key, "deadline") == 0)      dev->policy.deadline_ms = v;
+        else if (strcmp(key, "retries") == 0)  dev->policy.retries = v;
+        else if (strcmp(key, "backoff") == 0)  dev->policy.backoff_us = v;
+        else if (strcmp(key, "reopen") == 0)   dev->policy.reopen_after = v;
+        else if (strcmp(key, "adapter_timeout") == 0) dev->policy.adapter_timeout = v;
+        else
+            fprintf(stderr, "Ignoring unknown %s key: %s\n", AXP_I2C_POLICY_ENV, key);
+        spec = *end ? end + 1 : end;
+    }
+}
+
+AXP_API void axp_i2c_attach_metrics(axp_i2c_dev* dev) {
+    const char* path = getenv(AXP_METRICS_ENV);
+    if (!path || !*path)
+        return;
+    dev->metrics = axp_metrics_attach(path);
+    if (!dev->metrics)
+        perror("Attach metrics segment failed (continuing without)");
+}
+
+AXP_API bool axp_i2c_is_sim_path(const char* path) {
+    return strncmp(path, "sim", 3) == 0 && (path[3] == '\0' || path[3] == ':');
+}
+
+AXP_API int axp_i2c_open(axp_i2c_dev* dev, const char* path, uint16_t addr) {
+    dev->addr = addr;
+    dev->sim = NULL;
+    dev->fd = -1;
+    dev->ptr = 0;
+    dev->metrics = NULL;
+    dev->access = AXP_I2C_ACCESS_RDWR;
+    dev->funcs = 0;
+    dev->slave = -1;
+    dev->smbus = NULL;
+    memset(&dev->counters, 0, sizeof(dev->counters));
+    dev->fail_streak = 0;
+    dev->last_err = 0;
+    dev->jitter_seed = (unsigned)axp_metrics_now() ^ addr;
+    dev->path[0] = '\0';
+    axp_i2c_load_policy(dev);
+
+    if (axp_i2c_is_sim_path(path)) {
+        dev->sim = malloc(sizeof(axp_sim));
+        if (!dev->sim)
+            return -1;
+        if (axp_sim_init(dev->sim, path, addr) < 0) {
+            free(dev->sim);
+            dev->sim = NULL;
+            return -1;
+        }
+        dev->xfer = axp_i2c_xfer_sim;
+        dev->smbus = axp_i2c_smbus_sim;
+        dev->funcs = I2C_FUNC_I2C | I2C_FUNC_SMBUS_I2C_BLOCK | I2C_FUNC_SMBUS_BYTE_DATA;
+        if (axp_i2c_select_access(dev) < 0) {
+            free(dev->sim);
+            dev->sim = NULL;
+            return -1;
+        }
+        axp_i2c_attach_metrics(dev);
+        return 0;
+    }
+
+    if (axp_proto_is_path(path)) {
+        dev->fd = axp_proto_connect(path);
+        if (dev->fd < 0)
+            return -1;
+        dev->xfer = axp_i2c_xfer_srv;
+        dev->access = AXP_I2C_ACCESS_SERVER;
+        // Keine Metriken: axpd zaehlt die echten Bus-Transaktionen selbst,
+        // hier waeren es Socket-Roundtrips (auch Cache-Treffer)
+        return 0;
+    }
+
+    dev->fd = open(path, O_RDWR);
+    if (dev->fd < 0)
+        return -1;
+    dev->xfer = axp_i2c_xfer_dev;
+    dev->smbus = axp_i2c_smbus_dev;
+    if (strlen(path) < sizeof(dev->path))
+        strcpy(dev->path, path);
+    // Ohne I2C_FUNCS (sehr alte Kernel) bleibt es beim bisherigen I2C_RDWR
+    if (ioctl(dev->fd, I2C_FUNCS, &dev->funcs) < 0)
+        dev->funcs = I2C_FUNC_I2C;
+    if (axp_i2c_select_access(dev) < 0) {
+        close(dev->fd);
+        dev->fd = -1;
+        errno = EOPNOTSUPP;
+        return -1;
+    }
+    if (dev->policy.adapter_timeout)
+        axp_i2c_bound_adapter(dev);
+    axp_i2c_attach_metrics(dev);
+    return 0;
+}
+
+AXP_API void axp_i2c_close(axp_i2c_dev* dev) {
+    if (dev->fd >= 0)
+        close(dev->fd);
+    dev->fd = -1;
+    free(dev->sim);
+    dev->sim = NULL;
+    axp_metrics_detach(dev->metrics);
+    dev->metrics = NULL;
+}
+
+// Read `len` consecutive bytes starting at `reg` (auto-increment) in one
+// repeated-start transaction.
+AXP_API int axp_i2c_read_block(axp_i2c_dev* dev, uint8_t reg, uint8_t* buf, uint16_t len) {
+    struct i2c_msg msgs[2] = {
+        { .addr = dev->addr, .flags = 0,        .len = 1,   .buf = &reg },
+        { .addr = dev->addr, .flags = I2C_M_RD, .len = len, .buf = buf  },
+    };
+
+    if (axp_i2c_xfer(dev, msgs, 2) != 2)
+        return -1;
+    return 0;
+}
+
+// Read `count` arbitrary registers. Up to AXP_I2C_READS_PER_XFER registers
+// are fetched per ioctl, so a whole register table costs only a few
+// syscalls. Returns 0 on success, -1 if any transfer failed.
+AXP_API int axp_i2c_read_regs(axp_i2c_dev* dev, const uint8_t* regs, uint8_t* values, size_t count) {
+    struct i2c_msg msgs[I2C_RDWR_IOCTL_MAX_MSGS];
+    uint8_t ptrs[AXP_I2C_READS_PER_XFER];
+
+    for (size_t done = 0; done < count; ) {
+        size_t n = count - done;
+        if (n > AXP_I2C_READS_PER_XFER)
+            n = AXP_I2C_READS_PER_XFER;
+
+        for (size_t i = 0; i < n; ++i) {
+            ptrs[i] = regs[done + i];
+            msgs[2 * i]     = (struct i2c_msg){ .addr = dev->addr, .flags = 0,        .len = 1, .buf = &ptrs[i] };
+            msgs[2 * i + 1] = (struct i2c_msg){ .addr = dev->addr, .flags = I2C_M_RD, .len = 1, .buf = &values[done + i] };
+        }
+
+        if (axp_i2c_xfer(dev, msgs, 2 * n) != (int)(2 * n))
+            return -1;
+        done += n;
+    }
+    return 0;
+}
+
+// Write `count` registers; each (register, value) pair is one 2-byte
+// message and up to I2C_RDWR_IOCTL_MAX_MSGS of them go into one ioctl.
+AXP_API int axp_i2c_write_regs(axp_i2c_dev* dev, const uint8_t* regs, const uint8_t* values, size_t count) {
+    struct i2c_msg msgs[I2C_RDWR_IOCTL_MAX_MSGS];
+    uint8_t bufs[I2C_RDWR_IOCTL_MAX_MSGS][2];
+
+    for (size_t done = 0; done < count; ) {
+        size_t n = count - done;
+        if (n > I2C_RDWR_IOCTL_MAX_MSGS)
+            n = I2C_RDWR_IOCTL_MAX_MSGS;
+
+        for (size_t i = 0; i < n; ++i) {
+            bufs[i][0] = regs[done + i];
+            bufs[i][1] = values[done + i];
+            msgs[i] = (struct i2c_msg){ .addr = dev->addr, .flags = 0, .len = 2, .buf = bufs[i] };
+        }
+
+        if (axp_i2c_xfer(dev, msgs, n) != (int)n)
+            return -1;
+        done += n;
+    }
+    return 0;
+}
+
+// Write registers and read each one back in the same ioctl: per register a
+// 2-byte write, then a pointer write + 1-byte read. `readback` receives the
+// values as seen after the writes.
+#define AXP_I2C_VERIFY_PER_XFER (I2C_RDWR_IOCTL_MAX_MSGS / 3)
+
+AXP_API int axp_i2c_write_verify(axp_i2c_dev* dev, const uint8_t* regs, const uint8_t* values,
+                                 uint8_t* readback, size_t count) {
+    struct i2c_msg msgs[I2C_RDWR_IOCTL_MAX_MSGS];
+    uint8_t bufs[AXP_I2C_VERIFY_PER_XFER][2];
+    uint8_t ptrs[AXP_I2C_VERIFY_PER_XFER];
+
+    for (size_t done = 0; done < count; ) {
+        size_t n = count - done;
+        if (n > AXP_I2C_VERIFY_PER_XFER)
+            n = AXP_I2C_VERIFY_PER_XFER;
+
+        size_t m = 0;
+        for (size_t i = 0; i < n; ++i) {
+            bufs[i][0] = regs[done + i];
+            bufs[i][1] = values[done + i];
+            msgs[m++] = (struct i2c_msg){ .addr = dev->addr, .flags = 0, .len = 2, .buf = bufs[i] };
+        }
+        for (size_t i = 0; i < n; ++i) {
+            ptrs[i] = regs[done + i];
+            msgs[m++] = (struct i2c_msg){ .addr = dev->addr, .flags = 0,        .len = 1, .buf = &ptrs[i] };
+            msgs[m++] = (struct i2c_msg){ .addr = dev->addr, .flags = I2C_M_RD, .len = 1, .buf = &readback[done + i] };
+        }
+
+        if (axp_i2c_xfer(dev, msgs, m) != (int)m)
+            return -1;
+        done += n;
+    }
+    return 0;
+}
+
+// ==========================
+// Read-Planer (Block-Reads)
+// ==========================
+// The AXP223 auto-increments the register pointer, so a run of registers can
+// be fetched with one block read. The planner sorts the requested addresses
+// and merges those that are at most `gap` addresses apart into one span;
+// the skipped filler bytes are read and discarded.
+
+#define AXP_I2C_DEFAULT_GAP 4
+#define AXP_I2C_MAX_SPANS   256
+
+typedef struct {
+    uint8_t start;
+    uint16_t len;
+} axp_i2c_span;
+
+AXP_API int axp_i2c_cmp_u8(const void* a, const void* b) {
+    return (int)*(const uint8_t*)a - (int)*(const uint8_t*)b;
+}
+
+// Build the span list for `count` register addresses. Returns the number of
+// spans written to `spans` (at most `max_spans`).
+AXP_API size_t axp_i2c_plan_reads(const uint8_t* regs, size_t count, unsigned gap,
+                                  axp_i2c_span* spans, size_t max_spans) {
+    uint8_t sorted[256];
+    size_t n = 0;
+
+    // Duplikate entfernen, dann sortieren
+    uint8_t seen[256] = {0};
+    for (size_t i = 0; i < count; ++i) {
+        if (!seen[regs[i]]) {
+            seen[regs[i]] = 1;
+            sorted[n++] = regs[i];
+        }
+    }
+    qsort(sorted, n, 1, axp_i2c_cmp_u8);
+
+    size_t nspans = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (nspans > 0) {
+            axp_i2c_span* last = &spans[nspans - 1];
+            unsigned end = last->start + last->len - 1;
+            if (sorted[i] - end <= gap + 1) {
+                last->len = sorted[i] - last->start + 1;
+                continue;
+            }
+        }
+        if (nspans == max_spans)
+            break;
+        spans[nspans].start = sorted[i];
+        spans[nspans].len = 1;
+        nspans++;
+    }
+    return nspans;
+}
+
+// Execute a plan: every span becomes one pointer-write + block-read pair, and
+// up to AXP_I2C_READS_PER_XFER spans go into one ioctl. The bytes land in
+// `image` at their register address, so callers can scatter by address.
+AXP_API int axp_i2c_read_spans(axp_i2c_dev* dev, const axp_i2c_span* spans, size_t nspans,
+                               uint8_t image[256]) {
+    struct i2c_msg msgs[I2C_RDWR_IOCTL_MAX_MSGS];
+    uint8_t ptrs[AXP_I2C_READS_PER_XFER];
+
+    for (size_t done = 0; done < nspans; ) {
+        size_t n = nspans - done;
+        if (n > AXP_I2C_READS_PER_XFER)
+            n = AXP_I2C_READS_PER_XFER;
+
+        for (size_t i = 0; i < n; ++i) {
+            const axp_i2c_span* sp = &spans[done + i];
+            ptrs[i] = sp->start;
+            msgs[2 * i]     = (struct i2c_msg){ .addr = dev->addr, .flags = 0,        .len = 1,       .buf = &ptrs[i] };
+            msgs[2 * i + 1] = (struct i2c_msg){ .addr = dev->addr, .flags = I2C_M_RD, .len = sp->len, .buf = &image[sp->start] };
+        }
+
+        if (axp_i2c_xfer(dev, msgs, 2 * n) != (int)(2 * n))
+            return -1;
+        done += n;
+    }
+    return 0;
+}
+
+// ==========================
+// Register-Snapshot
+// ==========================
+// Full 256-byte register image plus a validity bitmap. It is filled once
+// per cycle and all decoders work on it, so every decoded value comes from
+// the same bus transaction and nothing is read twice.
+
+typedef struct {
+    uint8_t reg[256];
+    uint32_t valid[256 / 32];
+} axp_snapshot;
+
+AXP_API void axp_snapshot_clear(axp_snapshot* snap) {
+    memset(snap->valid, 0, sizeof(snap->valid));
+}
+
+AXP_API void axp_snapshot_set_valid(axp_snapshot* snap, uint8_t first, uint16_t count) {
+    for (unsigned r = first; r < (unsigned)first + count && r < 256; ++r)
+        snap->valid[r >> 5] |= 1u << (r & 31);
+}
+
+AXP_API void axp_snapshot_set_invalid(axp_snapshot* snap, uint8_t first, uint16_t count) {
+    for (unsigned r = first; r < (unsigned)first + count && r < 256; ++r)
+        snap->valid[r >> 5] &= ~(1u << (r & 31));
+}
+
+AXP_API bool axp_snapshot_is_valid(const axp_snapshot* snap, uint8_t reg) {
+    return (snap->valid[reg >> 5] >> (reg & 31)) & 1u;
+}
+
+// True if all `count` registers from `first` on are valid.
+AXP_API bool axp_snapshot_has(const axp_snapshot* snap, uint8_t first, uint16_t count) {
+    for (unsigned r = first; r < (unsigned)first + count; ++r)
+        if (r > 255 || !axp_snapshot_is_valid(snap, r))
+            return false;
+    return true;
+}
+
+// Registers that are valid in `cur` and were invalid or different in
+// `old`, as a bitmap in the layout of `valid`. The images are compared a
+// 64-bit word at a time; only words that differ are examined per byte.
+// Returns the number of changed registers.
+AXP_API size_t axp_snapshot_diff(const axp_snapshot* old, const axp_snapshot* cur,
+                                 uint32_t changed[256 / 32]) {
+    size_t n = 0;
+    memset(changed, 0, sizeof(uint32_t) * (256 / 32));
+
+    for (unsigned w = 0; w < 256 / 8; ++w) {
+        uint64_t a, b;
+        memcpy(&a, old->reg + 8 * w, 8);
+        memcpy(&b, cur->reg + 8 * w, 8);
+        uint32_t cur_valid = (cur->valid[w >> 2] >> (8 * (w & 3))) & 0xFF;
+        uint32_t new_valid = cur_valid & ~(old->valid[w >> 2] >> (8 * (w & 3)));
+        uint32_t bits = new_valid & 0xFF;
+
+        if (a != b) {
+            for (unsigned k = 0; k < 8; ++k)
+                if (old->reg[8 * w + k] != cur->reg[8 * w + k])
+                    bits |= cur_valid & (1u << k);
+        }
+        if (bits) {
+            changed[w >> 2] |= bits << (8 * (w & 3));
+            n += __builtin_popcount(bits);
+        }
+    }
+    return n;
+}
+
+AXP_API bool axp_bitmap_test(const uint32_t* map, unsigned reg) {
+    return (map[reg >> 5] >> (reg & 31)) & 1u;
+}
+
+// Fill the snapshot from a read plan. Spans are submitted in as few ioctls
+// as possible; spans of a failed ioctl stay invalid, the rest are still
+// read. Returns 0 if everything was read, -1 otherwise.
+AXP_API int axp_snapshot_read(axp_i2c_dev* dev, axp_snapshot* snap,
+                              const axp_i2c_span* spans, size_t nspans) {
+    int ret = 0;
+    axp_snapshot_clear(snap);
+
+    for (size_t done = 0; done < nspans; ) {
+        size_t n = nspans - done;
+        if (n > AXP_I2C_READS_PER_XFER)
+            n = AXP_I2C_READS_PER_XFER;
+
+        if (axp_i2c_read_spans(dev, spans + done, n, snap->reg) < 0) {
+            ret = -1;
+        } else {
+            for (size_t i = 0; i < n; ++i)
+                axp_snapshot_set_valid(snap, spans[done + i].start, spans[done + i].len);
+        }
+        done += n;
+    }
+    return ret;
+}
+
+// Single register read, kept for the simple call sites.
+AXP_API int axp_i2c_read_reg(axp_i2c_dev* dev, uint8_t reg) {
+    uint8_t val;
+    if (axp_i2c_read_block(dev, reg, &val, 1) < 0) {
+        perror("Read register failed");
+        return -1;
+    }
+    return val;
+}
+
+#endif // AXP223_I2C_H
@@ -0,0 +1,11 @@
+// ==========================
+// Gemeinsame Bibliothek des Multi-Call-Binaries
+// ==========================
+// The one external copy of the transaction layer, decoder, simulator,
+// metrics and axpd client code for axptool (see axp223_api.h). The applets
+// are compiled with -DAXP_SHARED and call into this translation unit; the
+// separate tools do not use it.
+
+#define AXP_SHARED
+#define AXP_IMPL
+#include "axp223_decode.h"
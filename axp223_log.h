@@ -0,0 +1,141 @@
+#ifndef AXP223_LOG_H
+#define AXP223_LOG_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// ==========================
+// Binaeres Sample-Log
+// ==========================
+// File layout:
+//   [axp_log_header, 64 bytes][axp_log_record, 16 bytes] * record_count
+//
+// Records hold the raw ADC bytes exactly as read from the PMIC; conversion
+// to mV/mA/degC happens offline (axplog_decode). The writer grows the file
+// in preallocated segments and writes records through an mmap'd window, so
+// the sampling path costs one memcpy per record and no write() syscalls.
+
+#define AXP_LOG_MAGIC       "AXPLOG1"
+#define AXP_LOG_VERSION     1
+#define AXP_LOG_SEGMENT     (1024 * 1024)   // Vielfaches der Seitengroesse und von 16
+
+// Register order inside axp_log_record.raw
+#define AXP_LOG_RAW_TEMP_H  0   // REG56
+#define AXP_LOG_RAW_TEMP_L  1   // REG57
+#define AXP_LOG_RAW_VBAT_H  2   // REG78
+#define AXP_LOG_RAW_VBAT_L  3   // REG79
+#define AXP_LOG_RAW_ICHG_H  4   // REG7A
+#define AXP_LOG_RAW_ICHG_L  5   // REG7B
+#define AXP_LOG_RAW_IDIS_H  6   // REG7C
+#define AXP_LOG_RAW_IDIS_L  7   // REG7D
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t record_size;
+    uint32_t rate_hz;
+    uint64_t start_ns;          // CLOCK_MONOTONIC beim Start
+    uint64_t record_count;      // wird laufend aktualisiert
+    uint64_t read_errors;       // Samples, die nicht gelesen werden konnten
+    uint8_t dev_addr;
+    uint8_t reserved[15];
+} axp_log_header;
+
+typedef struct {
+    uint64_t t_ns;              // CLOCK_MONOTONIC
+    uint8_t raw[8];
+} axp_log_record;
+
+_Static_assert(sizeof(axp_log_header) == 64, "log header must be 64 bytes");
+_Static_assert(sizeof(axp_log_record) == 16, "log record must be 16 bytes");
+
+typedef struct {
+    int fd;
+    axp_log_header* hdr;        // eigene Abbildung der ersten Seite
+    uint8_t* seg;               // aktuelles Segment
+    uint64_t seg_off;           // Dateioffset des Segments
+    uint64_t pos;               // naechster Schreiboffset in der Datei
+} axp_log_writer;
+
+static inline int axp_log_map_segment(axp_log_writer* w, uint64_t off) {
+    if (w->seg)
+        munmap(w->seg, AXP_LOG_SEGMENT);
+    w->seg = NULL;
+
+    // Segment vorab reservieren, damit das Schreiben ins Mapping nie auf
+    // einen fehlenden Block (SIGBUS) trifft
+    if (posix_fallocate(w->fd, off, AXP_LOG_SEGMENT) != 0 &&
+        ftruncate(w->fd, off + AXP_LOG_SEGMENT) < 0)
+        return -1;
+
+    void* p = mmap(NULL, AXP_LOG_SEGMENT, PROT_READ | PROT_WRITE, MAP_SHARED, w->fd, off);
+    if (p == MAP_FAILED)
+        return -1;
+    w->seg = p;
+    w->seg_off = off;
+    return 0;
+}
+
+static inline int axp_log_open(axp_log_writer* w, const char* path, uint8_t dev_addr,
+                               uint32_t rate_hz, uint64_t start_ns) {
+    memset(w, 0, sizeof(*w));
+    w->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (w->fd < 0)
+        return -1;
+
+    if (axp_log_map_segment(w, 0) < 0)
+        goto fail;
+    void* p = mmap(NULL, sizeof(axp_log_header), PROT_READ | PROT_WRITE, MAP_SHARED, w->fd, 0);
+    if (p == MAP_FAILED)
+        goto fail;
+    w->hdr = p;
+
+    memcpy(w->hdr->magic, AXP_LOG_MAGIC, sizeof(AXP_LOG_MAGIC));
+    w->hdr->version = AXP_LOG_VERSION;
+    w->hdr->header_size = sizeof(axp_log_header);
+    w->hdr->record_size = sizeof(axp_log_record);
+    w->hdr->rate_hz = rate_hz;
+    w->hdr->start_ns = start_ns;
+    w->hdr->dev_addr = dev_addr;
+    w->pos = sizeof(axp_log_header);
+    return 0;
+
+fail:
+    if (w->seg)
+        munmap(w->seg, AXP_LOG_SEGMENT);
+    close(w->fd);
+    w->fd = -1;
+    return -1;
+}
+
+static inline int axp_log_append(axp_log_writer* w, const axp_log_record* rec) {
+    if (w->pos - w->seg_off == AXP_LOG_SEGMENT &&
+        axp_log_map_segment(w, w->seg_off + AXP_LOG_SEGMENT) < 0)
+        return -1;
+    memcpy(w->seg + (w->pos - w->seg_off), rec, sizeof(*rec));
+    w->pos += sizeof(*rec);
+    w->hdr->record_count++;
+    return 0;
+}
+
+// Unmap, cut off the unused part of the last segment and close.
+static inline void axp_log_close(axp_log_writer* w) {
+    if (w->fd < 0)
+        return;
+    if (w->seg)
+        munmap(w->seg, AXP_LOG_SEGMENT);
+    if (w->hdr)
+        munmap(w->hdr, sizeof(axp_log_header));
+    if (ftruncate(w->fd, w->pos) < 0)
+        perror("Truncate log failed");
+    close(w->fd);
+    w->fd = -1;
+}
+
+#endif // AXP223_LOG_H
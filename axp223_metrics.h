@@ -0,0 +1,187 @@
+#ifndef AXP223_METRICS_H
+#define AXP223_METRICS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <linux/i2c.h>
+#include "axp223_api.h"
+
+// ==========================
+// Bus-Metriken
+// ==========================
+// Counters for every I2C transaction: transactions, messages, bytes, errors
+// by errno class, a log2 latency histogram and per-register read/write/error
+// counts. They live in a file-backed shared mapping (e.g. under /dev/shm)
+// named by the AXP_METRICS environment variable. Every tool that opens the
+// bus attaches to it, all updates are relaxed atomic adds, so several
+// processes can share one segment, and an exporter (axpmetrics) reads it
+// without touching the bus or taking a lock.
+
+#define AXP_METRICS_MAGIC    "AXPMET1"
+#define AXP_METRICS_VERSION  1
+#define AXP_METRICS_ENV      "AXP_METRICS"
+#define AXP_METRICS_BUCKETS  32     // Bucket k: [2^k, 2^(k+1)) ns
+
+enum {
+    AXP_ERR_REMOTEIO,   // NACK
+    AXP_ERR_TIMEDOUT,
+    AXP_ERR_AGAIN,      // Arbitration lost / Bus busy
+    AXP_ERR_NXIO,       // keine Antwort auf die Adresse
+    AXP_ERR_OTHER,
+    AXP_ERR_CLASSES,
+};
+
+#ifdef AXP_EXTERN_DATA
+extern const char* const axp_err_class_names[AXP_ERR_CLASSES];
+#else
+AXP_DATA const char* const axp_err_class_names[AXP_ERR_CLASSES] = {
+    "eremoteio", "etimedout", "eagain", "enxio", "other",
+};
+#endif
+
+typedef struct {
+    _Atomic uint64_t reads;     // gelesene Bytes dieses Registers
+    _Atomic uint64_t writes;
+    _Atomic uint64_t errors;    // fehlgeschlagene Transaktionen mit diesem Register
+} axp_metrics_reg;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t size;
+    uint64_t created_unix_ns;
+    _Atomic uint64_t xfers;
+    _Atomic uint64_t msgs;
+    _Atomic uint64_t bytes;
+    _Atomic uint64_t xfer_errors;
+    _Atomic uint64_t err_class[AXP_ERR_CLASSES];
+    _Atomic uint64_t latency_sum_ns;
+    _Atomic uint64_t latency_max_ns;
+    _Atomic uint64_t latency_hist[AXP_METRICS_BUCKETS];
+    axp_metrics_reg reg[256];
+} axp_metrics;
+
+AXP_API int axp_metrics_err_class(int err) {
+    switch (err) {
+    case EREMOTEIO: return AXP_ERR_REMOTEIO;
+    case ETIMEDOUT: return AXP_ERR_TIMEDOUT;
+    case EAGAIN:    return AXP_ERR_AGAIN;
+    case ENXIO:     return AXP_ERR_NXIO;
+    default:        return AXP_ERR_OTHER;
+    }
+}
+
+AXP_API uint64_t axp_metrics_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Map (and create on first use) the segment at `path`. Returns NULL on
+// failure. Creation and the header check run under flock(), so a tool
+// starting at the same moment never sees the segment sized but without
+// its magic yet.
+AXP_API axp_metrics* axp_metrics_attach(const char* path) {
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        return NULL;
+    if (flock(fd, LOCK_EX) < 0) {
+        close(fd);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (st.st_size != 0 && st.st_size != sizeof(axp_metrics))) {
+        close(fd);
+        errno = EINVAL;
+        return NULL;
+    }
+    if (st.st_size == 0 && ftruncate(fd, sizeof(axp_metrics)) < 0) {
+        close(fd);
+        return NULL;
+    }
+    void* p = mmap(NULL, sizeof(axp_metrics), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+
+    axp_metrics* m = p;
+    if (st.st_size == 0) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        m->created_unix_ns = (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+        m->version = AXP_METRICS_VERSION;
+        m->size = sizeof(axp_metrics);
+        memcpy(m->magic, AXP_METRICS_MAGIC, sizeof(AXP_METRICS_MAGIC));
+    } else if (memcmp(m->magic, AXP_METRICS_MAGIC, sizeof(AXP_METRICS_MAGIC)) != 0 ||
+               m->version != AXP_METRICS_VERSION) {
+        munmap(p, sizeof(axp_metrics));
+        close(fd);
+        errno = EINVAL;
+        return NULL;
+    }
+    close(fd);      // gibt auch den Lock frei
+    return m;
+}
+
+AXP_API void axp_metrics_detach(axp_metrics* m) {
+    if (m)
+        munmap(m, sizeof(*m));
+}
+
+AXP_API void axp_metrics_add(_Atomic uint64_t* c, uint64_t v) {
+    atomic_fetch_add_explicit(c, v, memory_order_relaxed);
+}
+
+// Account one transaction. `err` is 0 on success. Register attribution
+// follows the pointer writes in the message list, like the chip does.
+AXP_API void axp_metrics_record(axp_metrics* m, const struct i2c_msg* msgs, unsigned nmsgs,
+                                int err, uint64_t latency_ns) {
+    axp_metrics_add(&m->xfers, 1);
+    axp_metrics_add(&m->msgs, nmsgs);
+    axp_metrics_add(&m->latency_sum_ns, latency_ns);
+
+    uint64_t max = atomic_load_explicit(&m->latency_max_ns, memory_order_relaxed);
+    while (latency_ns > max &&
+           !atomic_compare_exchange_weak_explicit(&m->latency_max_ns, &max, latency_ns,
+                                                  memory_order_relaxed, memory_order_relaxed))
+        ;
+    unsigned bucket = 0;
+    for (uint64_t v = latency_ns; v > 1 && bucket < AXP_METRICS_BUCKETS - 1; v >>= 1)
+        bucket++;
+    axp_metrics_add(&m->latency_hist[bucket], 1);
+
+    if (err) {
+        axp_metrics_add(&m->xfer_errors, 1);
+        axp_metrics_add(&m->err_class[axp_metrics_err_class(err)], 1);
+    }
+
+    uint64_t bytes = 0;
+    unsigned ptr = 0;
+    for (unsigned i = 0; i < nmsgs; ++i) {
+        const struct i2c_msg* msg = &msgs[i];
+        bytes += msg->len;
+        if (msg->flags & I2C_M_RD) {
+            for (unsigned k = 0; k < msg->len; ++k, ++ptr)
+                axp_metrics_add(err ? &m->reg[ptr & 0xFF].errors : &m->reg[ptr & 0xFF].reads, 1);
+        } else if (msg->len > 0) {
+            ptr = msg->buf[0];
+            for (unsigned k = 1; k < msg->len; ++k, ++ptr)
+                axp_metrics_add(err ? &m->reg[ptr & 0xFF].errors : &m->reg[ptr & 0xFF].writes, 1);
+        }
+    }
+    axp_metrics_add(&m->bytes, bytes);
+}
+
+#endif // AXP223_METRICS_H
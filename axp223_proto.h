@@ -0,0 +1,202 @@
+#ifndef AXP223_PROTO_H
+#define AXP223_PROTO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <linux/i2c.h>
+#include "axp223_api.h"
+
+// ==========================
+// axpd Protokoll
+// ==========================
+// Binary request/response protocol between axpd (the resident PMIC server)
+// and its clients over a local SOCK_SEQPACKET Unix socket. Every packet is
+// one axp_proto_hdr followed by its payload, so no framing is needed; all
+// fields are host byte order since both ends run on the same machine.
+//
+//   op           request payload          response payload
+//   READ         -                        count values from reg on
+//   WRITE        count values             -
+//   READ_LIST    count addresses          count values
+//   WRITE_LIST   count (reg, value) pairs -
+//   SUBSCRIBE    -                        -      (then EVENT packets)
+//   UNSUBSCRIBE  -                        -
+//   EVENT        (server only)            count values from reg on
+//
+// Responses echo op/reg/count and carry 0 or an errno value in `status`.
+// Reads accept cached values up to `max_age_ms` old (AXP_PROTO_SERVER_TTL
+// uses the server's per-register TTL); for SUBSCRIBE it is the poll
+// interval, and an EVENT is sent whenever the range changed.
+// Use a separate connection for subscriptions: axp_proto_call() skips
+// EVENT packets while waiting for its response.
+
+#define AXP_PROTO_DEFAULT_SOCKET "/run/axpd.sock"
+#define AXP_PROTO_MAX_PAYLOAD    512
+#define AXP_PROTO_SERVER_TTL     0xFFFF
+
+enum {
+    AXP_OP_READ = 1,
+    AXP_OP_WRITE,
+    AXP_OP_READ_LIST,
+    AXP_OP_WRITE_LIST,
+    AXP_OP_SUBSCRIBE,
+    AXP_OP_UNSUBSCRIBE,
+    AXP_OP_EVENT,
+};
+
+typedef struct {
+    uint8_t op;
+    uint8_t status;
+    uint8_t reg;
+    uint8_t reserved;
+    uint16_t count;
+    uint16_t max_age_ms;
+} axp_proto_hdr;
+
+typedef struct {
+    axp_proto_hdr hdr;
+    uint8_t data[AXP_PROTO_MAX_PAYLOAD];
+} axp_proto_msg;
+
+// "axpd" or "axpd:/path/to/socket" as bus path selects the server
+AXP_API bool axp_proto_is_path(const char* path) {
+    return strncmp(path, "axpd", 4) == 0 && (path[4] == '\0' || path[4] == ':');
+}
+
+AXP_API int axp_proto_connect(const char* path) {
+    const char* sock = path[4] == ':' ? path + 5 : AXP_PROTO_DEFAULT_SOCKET;
+    struct sockaddr_un sa = { .sun_family = AF_UNIX };
+    if (strlen(sock) >= sizeof(sa.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(sa.sun_path, sock);
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, (struct sockaddr*)&sa, sizeof(sa)) < 0) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    return fd;
+}
+
+AXP_API int axp_proto_send(int fd, const axp_proto_msg* msg, size_t payload) {
+    size_t len = sizeof(msg->hdr) + payload;
+    return send(fd, msg, len, MSG_NOSIGNAL) == (ssize_t)len ? 0 : -1;
+}
+
+// Receive the next non-EVENT packet. Returns its payload length, or -1.
+AXP_API int axp_proto_recv(int fd, axp_proto_msg* msg) {
+    for (;;) {
+        ssize_t n = recv(fd, msg, sizeof(*msg), 0);
+        if (n < 0)
+            return -1;
+        if (n < (ssize_t)sizeof(msg->hdr)) {
+            errno = n == 0 ? ECONNRESET : EPROTO;
+            return -1;
+        }
+        if (msg->hdr.op != AXP_OP_EVENT)
+            return (int)(n - sizeof(msg->hdr));
+    }
+}
+
+// One request/response round trip. Returns the response payload length,
+// or -1 with errno set (including the server's status).
+AXP_API int axp_proto_call(int fd, axp_proto_msg* msg, size_t payload) {
+    if (axp_proto_send(fd, msg, payload) < 0)
+        return -1;
+    int n = axp_proto_recv(fd, msg);
+    if (n >= 0 && msg->hdr.status) {
+        errno = msg->hdr.status;
+        return -1;
+    }
+    return n;
+}
+
+// I2C_RDWR message list -> protocol requests, so every tool can go through
+// the server unchanged. Pointer write + read becomes READ, a write with
+// data becomes WRITE; `ptr` tracks the register pointer across calls like
+// the chip does. All requests are sent first and the responses collected
+// afterwards, so a whole ioctl costs one round trip.
+AXP_API int axp_proto_xfer(int fd, uint8_t* ptr, struct i2c_msg* msgs, unsigned nmsgs) {
+    struct i2c_msg* targets[I2C_RDWR_IOCTL_MAX_MSGS];
+    axp_proto_msg req;
+    unsigned sent = 0;
+
+    if (nmsgs > I2C_RDWR_IOCTL_MAX_MSGS) {
+        errno = EINVAL;
+        return -1;
+    }
+    for (unsigned i = 0; i < nmsgs; ++i) {
+        struct i2c_msg* m = &msgs[i];
+        memset(&req.hdr, 0, sizeof(req.hdr));
+        size_t payload = 0;
+
+        if (!(m->flags & I2C_M_RD)) {
+            if (m->len == 0)
+                continue;
+            *ptr = m->buf[0];
+            if (m->len == 1)
+                continue;
+            if (*ptr + m->len - 1 > 256 || m->len - 1 > AXP_PROTO_MAX_PAYLOAD) {
+                errno = EINVAL;
+                return -1;
+            }
+            req.hdr.op = AXP_OP_WRITE;
+            req.hdr.reg = *ptr;
+            req.hdr.count = m->len - 1;
+            memcpy(req.data, m->buf + 1, m->len - 1);
+            payload = m->len - 1;
+            targets[sent] = NULL;
+            *ptr += m->len - 1;
+        } else {
+            if (*ptr + m->len > 256) {
+                errno = EINVAL;
+                return -1;
+            }
+            req.hdr.op = AXP_OP_READ;
+            req.hdr.reg = *ptr;
+            req.hdr.count = m->len;
+            req.hdr.max_age_ms = AXP_PROTO_SERVER_TTL;
+            targets[sent] = m;
+            *ptr += m->len;
+        }
+
+        if (axp_proto_send(fd, &req, payload) < 0)
+            return -1;
+        sent++;
+    }
+
+    int err = 0;
+    axp_proto_msg resp;
+    for (unsigned i = 0; i < sent; ++i) {
+        int n = axp_proto_recv(fd, &resp);
+        if (n < 0)
+            return -1;
+        if (resp.hdr.status) {
+            err = resp.hdr.status;
+        } else if (targets[i]) {
+            if (n != targets[i]->len) {
+                err = EPROTO;
+                continue;
+            }
+            memcpy(targets[i]->buf, resp.data, n);
+        }
+    }
+    if (err) {
+        errno = err;
+        return -1;
+    }
+    return nmsgs;
+}
+
+#endif // AXP223_PROTO_H
@@ -0,0 +1,148 @@
+#ifndef AXP223_REGS_H
+#define AXP223_REGS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Register map shared by the tools. Every tool is a single translation
+// unit, so each gets its own copy of the table (and of the .value slots).
+
+#define MAX_REGISTERS 128
+
+typedef struct {
+    uint8_t address;
+    const char* name;
+    const char* section;
+    uint8_t value;
+} AXP223_Register;
+
+// ==========================
+// Alle relevanten Register
+// ==========================
+static AXP223_Register registers[] = {
+    // Power Control (10.1.1)
+    {0x00, "Power Status", "Power Control"},
+    {0x01, "Charge State", "Power Control"},
+    {0x10, "Power Enable 1", "Power Control"},
+    {0x12, "Power Enable 2", "Power Control"},
+    {0x13, "ALDO3 Enable", "Power Control"},
+    {0x15, "DLDO1 Voltage", "Power Control"},
+    {0x16, "DLDO2 Voltage", "Power Control"},
+    {0x17, "DLDO3 Voltage", "Power Control"},
+    {0x18, "DLDO4 Voltage", "Power Control"},
+    {0x19, "ELDO1 Voltage", "Power Control"},
+    {0x1A, "ELDO2 Voltage", "Power Control"},
+    {0x1B, "ELDO3 Voltage", "Power Control"},
+    {0x1C, "DC5LDO Voltage", "Power Control"},
+    {0x21, "DCDC1 Voltage", "Power Control"},
+    {0x22, "DCDC2 Voltage", "Power Control"},
+    {0x23, "DCDC3 Voltage", "Power Control"},
+    {0x24, "DCDC4 Voltage", "Power Control"},
+    {0x25, "DCDC5 Voltage", "Power Control"},
+    {0x27, "DCDC2/3 Ramp", "Power Control"},
+    {0x28, "ALDO1 Voltage", "Power Control"},
+    {0x29, "ALDO2 Voltage", "Power Control"},
+    {0x2A, "ALDO3 Voltage", "Power Control"},
+    {0x30, "VBUS Path Ctrl", "Power Control"},
+    {0x31, "Wakeup + VOFF", "Power Control"},
+    {0x32, "Shutdown + LED", "Power Control"},
+    {0x33, "Charge Ctrl 1", "Power Control"},
+    {0x34, "Charge Ctrl 2", "Power Control"},
+    {0x35, "Charge Ctrl 3", "Power Control"},
+    {0x36, "PEK Parameters", "Power Control"},
+    {0x37, "DCDC Frequency", "Power Control"},
+    {0x38, "Temp Warn Low", "Power Control"},
+    {0x39, "Temp Warn High", "Power Control"},
+    {0x3C, "Temp Warn Disch Low", "Power Control"},
+    {0x3D, "Temp Warn Disch High", "Power Control"},
+
+    // GPIO Control (10.1.2)
+    {0x90, "GPIO0 Ctrl", "GPIO"},
+    {0x91, "GPIO0 Voltage", "GPIO"},
+    {0x92, "GPIO1 Ctrl", "GPIO"},
+    {0x93, "GPIO1 Voltage", "GPIO"},
+    {0x94, "GPIO Status", "GPIO"},
+    {0x97, "GPIO Pull-Down", "GPIO"},
+
+    // Interrupt Control (10.1.3)
+    {0x40, "IRQ Enable 1", "Interrupt"},
+    {0x41, "IRQ Enable 2", "Interrupt"},
+    {0x42, "IRQ Enable 3", "Interrupt"},
+    {0x43, "IRQ Enable 4", "Interrupt"},
+    {0x44, "IRQ Enable 5", "Interrupt"},
+    {0x48, "IRQ Status 1", "Interrupt"},
+    {0x49, "IRQ Status 2", "Interrupt"},
+    {0x4A, "IRQ Status 3", "Interrupt"},
+    {0x4B, "IRQ Status 4", "Interrupt"},
+    {0x4C, "IRQ Status 5", "Interrupt"},
+
+    // ADC Data (10.1.4)
+    {0x56, "Temp ADC High", "ADC"},
+    {0x57, "Temp ADC Low", "ADC"},
+    {0x58, "TS ADC High", "ADC"},
+    {0x59, "TS ADC Low", "ADC"},
+    {0x78, "Battery Volt High", "ADC"},
+    {0x79, "Battery Volt Low", "ADC"},
+    {0x7A, "Charge Curr High", "ADC"},
+    {0x7B, "Charge Curr Low", "ADC"},
+    {0x7C, "Discharge Curr High", "ADC"},
+    {0x7D, "Discharge Curr Low", "ADC"},
+	
+	    // Weitere Steuer-/Fuel-Gauge/ADC-Register
+    {0x80, "DCDC Mode", "ADC"},
+    {0x82, "ADC Enable", "ADC"},
+    {0x84, "ADC Sample + TS", "ADC"},
+    {0x85, "TS Sample Rate", "ADC"},
+    {0x8A, "Timer Control", "Timer"},
+    {0x8C, "PWREN Control 1", "Power Control"},
+    {0x8D, "PWREN Control 2", "Power Control"},
+    {0x8F, "Overtemp Shutdown", "Power Control"},
+    {0xB8, "Fuel Gauge Ctrl", "Fuel Gauge"},
+    {0xB9, "Fuel Gauge Result", "Fuel Gauge"},
+    {0xE0, "Battery Cap Hi", "Fuel Gauge"},
+    {0xE1, "Battery Cap Lo", "Fuel Gauge"},
+    {0xE6, "Battery Alarm", "Fuel Gauge"},
+    {0xE8, "FG Update Interval", "Fuel Gauge"},
+    {0xE9, "FG Calibration Interval", "Fuel Gauge"},
+    {0xEC, "FG Capacity % Calib", "Fuel Gauge"}
+
+};
+
+#define REGISTER_COUNT (sizeof(registers) / sizeof(registers[0]))
+
+// Status, ADC results and write-1-to-clear IRQ flags: listed in the table
+// but never written back by a snapshot restore
+static const uint8_t readonly_registers[] = {
+    0x00, 0x01,                         // Power Status, Charge State
+    0x48, 0x49, 0x4A, 0x4B, 0x4C,       // IRQ Status (W1C)
+    0x56, 0x57, 0x58, 0x59,             // Temp/TS ADC
+    0x78, 0x79, 0x7A, 0x7B, 0x7C, 0x7D, // Battery ADC
+    0x94,                               // GPIO Status
+    0xB9,                               // Fuel Gauge Result
+};
+
+// Name of a table register, NULL if it is not in the table
+static inline const char* register_name(uint8_t reg) {
+    for (size_t i = 0; i < REGISTER_COUNT; ++i)
+        if (registers[i].address == reg)
+            return registers[i].name;
+    return NULL;
+}
+
+// IRQ status REG48-REG4C: a 1 clears the bit, a 0 leaves it alone
+static inline bool register_w1c(uint8_t reg) {
+    return reg >= 0x48 && reg <= 0x4C;
+}
+
+// Writable = in the table and not read-only
+static inline bool register_writable(uint8_t reg) {
+    if (!register_name(reg))
+        return false;
+    for (size_t i = 0; i < sizeof(readonly_registers); ++i)
+        if (readonly_registers[i] == reg)
+            return false;
+    return true;
+}
+
+#endif // AXP223_REGS_H
@@ -0,0 +1,57 @@
+#ifndef AXP223_RING_H
+#define AXP223_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// ==========================
+// ADC Sample Ring (SPSC)
+// ==========================
+// Lock-free single-producer/single-consumer ring of raw ADC samples. The
+// storage is a fixed array, so nothing is allocated once sampling runs.
+// The producer (sampling loop) never blocks: when the ring is full the
+// sample is dropped and counted.
+
+#define AXP_RING_SIZE 4096  // muss eine Zweierpotenz sein
+#define AXP_RING_MASK (AXP_RING_SIZE - 1)
+
+typedef struct {
+    uint64_t t_ns;      // CLOCK_MONOTONIC
+    uint8_t adc[6];     // REG78..REG7D roh
+    uint8_t temp[2];    // REG56..REG57 roh
+    uint8_t irq[5];     // REG48..REG4C roh, nur mit --capture gelesen
+    uint8_t ok;         // 0 = Lesefehler
+    uint8_t missed;     // verpasste Timer-Ticks vor diesem Sample
+} axp_sample;
+
+typedef struct {
+    _Atomic uint32_t head;  // nur vom Producer geschrieben
+    _Atomic uint32_t tail;  // nur vom Consumer geschrieben
+    _Atomic uint32_t dropped;
+    axp_sample slots[AXP_RING_SIZE];
+} axp_ring;
+
+static inline bool axp_ring_push(axp_ring* ring, const axp_sample* s) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail == AXP_RING_SIZE) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return false;
+    }
+    ring->slots[head & AXP_RING_MASK] = *s;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return true;
+}
+
+static inline bool axp_ring_pop(axp_ring* ring, axp_sample* s) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (head == tail)
+        return false;
+    *s = ring->slots[tail & AXP_RING_MASK];
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+#endif // AXP223_RING_H
@@ -0,0 +1,100 @@
+#ifndef AXP223_SCHED_H
+#define AXP223_SCHED_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ==========================
+// Poll-Scheduler
+// ==========================
+// Deadline-ordered min-heap with one entry per register, each with its own
+// poll period. axp_sched_pop_due() takes every register due now (or within
+// `slack`), so registers that fall due together are read in one batched
+// transaction. Rescheduling keeps each register's phase, which keeps
+// registers with related periods (100 ms / 1 s / 10 s) aligned and merged.
+
+typedef struct {
+    uint64_t due_ns;
+    uint64_t period_ns;
+    uint8_t reg;
+} axp_sched_entry;
+
+typedef struct {
+    axp_sched_entry heap[256];
+    size_t n;
+} axp_sched;
+
+static inline void axp_sched_init(axp_sched* s) {
+    s->n = 0;
+}
+
+static inline int axp_sched_before(const axp_sched_entry* a, const axp_sched_entry* b) {
+    return a->due_ns < b->due_ns || (a->due_ns == b->due_ns && a->reg < b->reg);
+}
+
+static inline void axp_sched_sift_up(axp_sched* s, size_t i) {
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!axp_sched_before(&s->heap[i], &s->heap[parent]))
+            break;
+        axp_sched_entry tmp = s->heap[i];
+        s->heap[i] = s->heap[parent];
+        s->heap[parent] = tmp;
+        i = parent;
+    }
+}
+
+static inline void axp_sched_sift_down(axp_sched* s, size_t i) {
+    for (;;) {
+        size_t l = 2 * i + 1, r = l + 1, m = i;
+        if (l < s->n && axp_sched_before(&s->heap[l], &s->heap[m]))
+            m = l;
+        if (r < s->n && axp_sched_before(&s->heap[r], &s->heap[m]))
+            m = r;
+        if (m == i)
+            break;
+        axp_sched_entry tmp = s->heap[i];
+        s->heap[i] = s->heap[m];
+        s->heap[m] = tmp;
+        i = m;
+    }
+}
+
+// First poll of every register is at `start_ns`. Returns -1 if full.
+static inline int axp_sched_add(axp_sched* s, uint8_t reg, uint32_t period_ms, uint64_t start_ns) {
+    if (s->n == sizeof(s->heap) / sizeof(s->heap[0]) || period_ms == 0)
+        return -1;
+    s->heap[s->n] = (axp_sched_entry){ start_ns, (uint64_t)period_ms * 1000000ull, reg };
+    axp_sched_sift_up(s, s->n++);
+    return 0;
+}
+
+// Deadline of the next register, UINT64_MAX if empty
+static inline uint64_t axp_sched_next(const axp_sched* s) {
+    return s->n ? s->heap[0].due_ns : UINT64_MAX;
+}
+
+// Pop every register due by now + slack_ns into `regs` (room for 256) and
+// schedule its next poll. Deadlines missed by more than a period are
+// skipped instead of replayed. Returns the number of registers.
+static inline size_t axp_sched_pop_due(axp_sched* s, uint64_t now, uint64_t slack_ns, uint8_t* regs) {
+    uint32_t popped[256 / 32] = {0};
+    size_t count = 0;
+
+    while (s->n && s->heap[0].due_ns <= now + slack_ns) {
+        axp_sched_entry* top = &s->heap[0];
+        // jedes Register hoechstens einmal pro Runde (Periode < slack)
+        if ((popped[top->reg >> 5] >> (top->reg & 31)) & 1u)
+            break;
+        popped[top->reg >> 5] |= 1u << (top->reg & 31);
+        regs[count++] = top->reg;
+
+        top->due_ns += top->period_ns;
+        if (top->due_ns <= now)
+            top->due_ns += (now - top->due_ns) / top->period_ns * top->period_ns + top->period_ns;
+        axp_sched_sift_down(s, 0);
+    }
+    return count;
+}
+
+#endif // AXP223_SCHED_H
@@ -0,0 +1,253 @@
+#ifndef AXP223_SIM_H
+#define AXP223_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <linux/i2c.h>
+#include "axp223_api.h"
+
+// ==========================
+// AXP223 Simulator
+// ==========================
+// In-process model of the AXP223 register file behind the same message
+// interface as I2C_RDWR, so every tool can run without hardware by passing
+// "sim" (or "sim:key=value,...") as the bus path. Modelled behaviour:
+//   - register pointer with auto-increment for block reads and writes
+//   - read-only status/ADC registers, write-1-to-clear IRQ status 0x48-0x4C
+//   - synthetic ADC waveforms (battery voltage, charge/discharge current,
+//     internal temperature) following a triangle over `period` ms, updated
+//     only at the ADC rate of REG84, optionally with LSB noise and a
+//     clock error against the nominal rate
+//   - optional periodic PEK short-press IRQ
+//   - per-transaction and per-byte latency, random transaction errors
+//   - random bus stalls that end in ETIMEDOUT after `stall_ms`
+//
+// Options: addr=<hex>, latency=<us per transaction>, byte_ns=<ns per byte>,
+//          errors=<permille>, stalls=<permille>, stall_ms=<ms>, period=<ms>,
+//          irq=<ms>, noise=<LSB>, adc_ppm=<signed ppm>, seed=<n>
+
+typedef struct {
+    uint8_t reg[256];
+    uint8_t ptr;
+    uint16_t addr;
+    uint32_t latency_us;
+    uint32_t byte_ns;
+    uint32_t error_permille;
+    uint32_t stall_permille;
+    uint32_t stall_ms;
+    uint32_t period_ms;
+    uint32_t irq_ms;
+    uint32_t noise_lsb;
+    int32_t adc_ppm;
+    unsigned seed;
+    uint64_t start_ns;
+    uint64_t last_irq_ns;
+    uint64_t xfers;
+    uint64_t errors;
+} axp_sim;
+
+AXP_API uint64_t axp_sim_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+AXP_API bool axp_sim_read_only(uint8_t reg) {
+    return reg == 0x00 || reg == 0x01 || (reg >= 0x56 && reg <= 0x59) ||
+           (reg >= 0x78 && reg <= 0x7D);
+}
+
+// Plausible power-on state of a charging board on USB
+AXP_API void axp_sim_reset(axp_sim* sim) {
+    memset(sim->reg, 0, sizeof(sim->reg));
+    sim->reg[0x00] = 0x3C;  // VBUS present/usable, > VHOLD, charging
+    sim->reg[0x01] = 0x60;  // charging, battery present
+    sim->reg[0x10] = 0x3F;
+    sim->reg[0x12] = 0x80;
+    sim->reg[0x15] = 0x16;  // DLDO1..4
+    sim->reg[0x16] = 0x16;
+    sim->reg[0x21] = 0x11;  // DCDC1
+    sim->reg[0x22] = 0x4B;
+    sim->reg[0x23] = 0x4B;
+    sim->reg[0x30] = 0x63;
+    sim->reg[0x31] = 0x03;
+    sim->reg[0x32] = 0x43;
+    sim->reg[0x33] = 0xC8;  // charger on, 4.2 V, 1500 mA
+    sim->reg[0x34] = 0x45;
+    sim->reg[0x35] = 0x05;
+    sim->reg[0x36] = 0x59;
+    sim->reg[0x40] = 0xD8;  // IRQ enables
+    sim->reg[0x41] = 0xFC;
+    sim->reg[0x42] = 0x03;
+    sim->reg[0x43] = 0x03;
+    sim->reg[0x44] = 0x60;
+    sim->reg[0x82] = 0xE0;  // TS, battery voltage and current ADC on
+    sim->reg[0x84] = 0xF2;
+    sim->reg[0xB8] = 0xC0;  // fuel gauge + coulomb counter
+    sim->reg[0xB9] = 0xE4;  // 100 %
+    sim->reg[0xE0] = 0x85;  // 2000 mAh configured
+    sim->reg[0xE1] = 0x5D;
+}
+
+// Deterministic noise in [-noise, noise] LSB for conversion `k`
+AXP_API int32_t axp_sim_noise(const axp_sim* sim, uint64_t k, unsigned channel) {
+    if (!sim->noise_lsb)
+        return 0;
+    uint64_t x = (k * 4 + channel + 1) * 0x9E3779B97F4A7C15ull;     // splitmix64
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return (int32_t)(x % (2 * sim->noise_lsb + 1)) - (int32_t)sim->noise_lsb;
+}
+
+AXP_API uint32_t axp_sim_add(uint32_t raw, int32_t d) {
+    return d < 0 && (uint32_t)-d > raw ? 0 : raw + d;
+}
+
+// Recompute the ADC and status registers for the current time
+AXP_API void axp_sim_update(axp_sim* sim, uint64_t now) {
+    // ADC-Register aendern sich nur bei einer Wandlung (REG84[7:6], 100 << n Hz),
+    // der ADC-Takt weicht um adc_ppm vom Nennwert ab
+    uint64_t conv_ps = 1000000000000ull / (100u << (sim->reg[0x84] >> 6));
+    conv_ps = conv_ps * 1000000 / (uint64_t)(1000000 + sim->adc_ppm);
+    uint64_t k = (now - sim->start_ns) * 1000 / conv_ps;
+    uint64_t t = sim->start_ns + k * conv_ps / 1000;
+
+    uint64_t period_ns = (uint64_t)(sim->period_ms ? sim->period_ms : 60000) * 1000000ull;
+    uint32_t p = (uint32_t)(((t - sim->start_ns) % period_ns) * 1000 / period_ns);     // 0..999
+    uint32_t tri = p < 500 ? p * 2 : (999 - p) * 2;                                    // 0..998
+    bool charging = p < 500;
+
+    uint32_t mv = 3600 + 600 * tri / 1000;
+    uint32_t vraw = axp_sim_add(mv * 10 / 11, axp_sim_noise(sim, k, 0));                // 1.1 mV/LSB
+    uint32_t chg = charging ? axp_sim_add((200 + 600 * tri / 1000) * 2, axp_sim_noise(sim, k, 1)) : 0;
+    uint32_t dis = charging ? 0 : axp_sim_add((150 + 350 * tri / 1000) * 2, axp_sim_noise(sim, k, 2));
+    uint32_t traw = axp_sim_add(300 + 150 * tri / 1000 + 1447, axp_sim_noise(sim, k, 3)); // 0.1 K/LSB - 144.7
+
+    sim->reg[0x56] = traw >> 4;
+    sim->reg[0x57] = traw & 0x0F;
+    sim->reg[0x78] = vraw >> 4;
+    sim->reg[0x79] = vraw & 0x0F;
+    sim->reg[0x7A] = chg >> 5;
+    sim->reg[0x7B] = chg & 0x1F;
+    sim->reg[0x7C] = dis >> 5;
+    sim->reg[0x7D] = dis & 0x1F;
+    sim->reg[0x00] = (sim->reg[0x00] & ~0x04) | (charging ? 0x04 : 0);
+    sim->reg[0x01] = (sim->reg[0x01] & ~0x40) | (charging ? 0x40 : 0);
+
+    if (sim->irq_ms && now - sim->last_irq_ns >= (uint64_t)sim->irq_ms * 1000000ull) {
+        sim->reg[0x4A] |= 0x02;     // PEK short press
+        sim->last_irq_ns = now;
+    }
+}
+
+AXP_API void axp_sim_write(axp_sim* sim, uint8_t reg, uint8_t val) {
+    if (reg >= 0x48 && reg <= 0x4C)
+        sim->reg[reg] &= ~val;      // write 1 to clear
+    else if (!axp_sim_read_only(reg))
+        sim->reg[reg] = val;
+}
+
+// Execute one combined transaction. Returns nmsgs or -1 with errno set,
+// like ioctl(I2C_RDWR).
+AXP_API int axp_sim_xfer(axp_sim* sim, struct i2c_msg* msgs, unsigned nmsgs) {
+    uint64_t now = axp_sim_now_ns();
+    size_t bytes = 0;
+    sim->xfers++;
+
+    for (unsigned i = 0; i < nmsgs; ++i) {
+        if (msgs[i].addr != sim->addr) {
+            sim->errors++;
+            errno = ENXIO;
+            return -1;
+        }
+        bytes += msgs[i].len + 1;
+    }
+    if (sim->error_permille && (unsigned)(rand_r(&sim->seed) % 1000) < sim->error_permille) {
+        sim->errors++;
+        errno = EREMOTEIO;
+        return -1;
+    }
+    if (sim->stall_permille && (unsigned)(rand_r(&sim->seed) % 1000) < sim->stall_permille) {
+        // SDA low gehalten: der Adapter bricht erst nach seinem Timeout ab
+        struct timespec ts = { sim->stall_ms / 1000, (sim->stall_ms % 1000) * 1000000l };
+        while (nanosleep(&ts, &ts) < 0 && errno == EINTR)
+            ;
+        sim->errors++;
+        errno = ETIMEDOUT;
+        return -1;
+    }
+
+    axp_sim_update(sim, now);
+    for (unsigned i = 0; i < nmsgs; ++i) {
+        struct i2c_msg* m = &msgs[i];
+        if (m->flags & I2C_M_RD) {
+            for (unsigned k = 0; k < m->len; ++k)
+                m->buf[k] = sim->reg[sim->ptr++];
+        } else if (m->len > 0) {
+            sim->ptr = m->buf[0];
+            for (unsigned k = 1; k < m->len; ++k)
+                axp_sim_write(sim, sim->ptr++, m->buf[k]);
+        }
+    }
+
+    uint64_t delay_ns = (uint64_t)sim->latency_us * 1000 + (uint64_t)sim->byte_ns * bytes;
+    if (delay_ns) {
+        struct timespec ts = { delay_ns / 1000000000ull, delay_ns % 1000000000ull };
+        while (nanosleep(&ts, &ts) < 0 && errno == EINTR)
+            ;
+    }
+    return nmsgs;
+}
+
+// Parse "sim" / "sim:key=value,...". Returns 0 on success.
+AXP_API int axp_sim_init(axp_sim* sim, const char* spec, uint16_t addr) {
+    memset(sim, 0, sizeof(*sim));
+    sim->addr = addr;
+    sim->seed = 1;
+    sim->stall_ms = 20;
+    sim->start_ns = sim->last_irq_ns = axp_sim_now_ns();
+    axp_sim_reset(sim);
+
+    const char* p = strchr(spec, ':');
+    while (p && *++p) {
+        char key[16];
+        size_t n = strcspn(p, "=");
+        if (n == 0 || n >= sizeof(key) || p[n] != '=') {
+            errno = EINVAL;
+            return -1;
+        }
+        memcpy(key, p, n);
+        key[n] = '\0';
+        char* end;
+        unsigned long v = strtoul(p + n + 1, &end, strcmp(key, "addr") == 0 ? 16 : 10);
+
+        if (strcmp(key, "addr") == 0)          sim->addr = v;
+        else if (strcmp(key, "latency") == 0)  sim->latency_us = v;
+        else if (strcmp(key, "byte_ns") == 0)  sim->byte_ns = v;
+        else if (strcmp(key, "errors") == 0)   sim->error_permille = v;
+        else if (strcmp(key, "stalls") == 0)   sim->stall_permille = v;
+        else if (strcmp(key, "stall_ms") == 0) sim->stall_ms = v;
+        else if (strcmp(key, "period") == 0)   sim->period_ms = v;
+        else if (strcmp(key, "irq") == 0)      sim->irq_ms = v;
+        else if (strcmp(key, "noise") == 0)    sim->noise_lsb = v;
+        else if (strcmp(key, "adc_ppm") == 0)  sim->adc_ppm = (int32_t)strtol(p + n + 1, &end, 10);
+        else if (strcmp(key, "seed") == 0)     sim->seed = v;
+        else {
+            errno = EINVAL;
+            return -1;
+        }
+        p = *end == ',' ? end : NULL;
+        if (*end && *end != ',') {
+            errno = EINVAL;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+#endif // AXP223_SIM_H
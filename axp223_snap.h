@@ -0,0 +1,68 @@
+#ifndef AXP223_SNAP_H
+#define AXP223_SNAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// ==========================
+// Snapshot-Datei
+// ==========================
+// All 256 registers of one PMIC as a fixed 352-byte file: the register
+// image, which registers were read successfully, and which of them a
+// restore may write. The writability mask is stored with the snapshot, so
+// a restore does what the snapshot was taken for even if the tool's
+// register table changes later.
+
+#define AXP_SNAP_MAGIC    "AXPSNP1"
+#define AXP_SNAP_VERSION  1
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t size;
+    uint64_t created_unix_ns;
+    uint8_t dev_addr;
+    uint8_t reserved[7];
+    uint32_t valid[256 / 32];
+    uint32_t writable[256 / 32];
+    uint8_t reg[256];
+} axp_snap_file;
+
+_Static_assert(sizeof(axp_snap_file) == 352, "snapshot file must be 352 bytes");
+
+static inline int axp_snap_save(const char* path, const axp_snap_file* snap) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return -1;
+    ssize_t n = write(fd, snap, sizeof(*snap));
+    int ret = n == (ssize_t)sizeof(*snap) && fsync(fd) == 0 ? 0 : -1;
+    int err = n >= 0 && n != (ssize_t)sizeof(*snap) ? EIO : errno;
+    close(fd);
+    if (ret < 0)
+        errno = err;
+    return ret;
+}
+
+static inline int axp_snap_load(const char* path, axp_snap_file* snap) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    ssize_t n = read(fd, snap, sizeof(*snap));
+    char extra;
+    bool trailing = n == (ssize_t)sizeof(*snap) && read(fd, &extra, 1) > 0;
+    close(fd);
+    if (n != (ssize_t)sizeof(*snap) || trailing ||
+        memcmp(snap->magic, AXP_SNAP_MAGIC, sizeof(AXP_SNAP_MAGIC)) != 0 ||
+        snap->version != AXP_SNAP_VERSION || snap->size != sizeof(*snap)) {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+#endif // AXP223_SNAP_H
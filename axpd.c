@@ -0,0 +1,498 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "axp223_i2c.h"
+
+// ==========================
+// axpd - PMIC-Server
+// ==========================
+// Owns the I2C fd and serves register reads/writes to local clients over
+// the axp223_proto.h socket protocol. A register cache with per-register
+// TTLs answers reads; only registers older than the allowed age go to the
+// bus. All requests that arrive in one poll round are collected first and
+// their stale registers fetched with a single planned read, so concurrent
+// readers share bus transactions. The server is single-threaded, which
+// serialises all bus access.
+
+#define MAX_CLIENTS      32
+#define MAX_SUBS         8
+#define MAX_PENDING      (MAX_CLIENTS * 8)
+#define RECV_PER_ROUND   8
+
+#define DEFAULT_TTL_MS          5000
+#define DEFAULT_VOLATILE_TTL_MS 100
+
+typedef struct {
+    uint8_t reg;
+    uint16_t count;
+    uint16_t interval_ms;
+    uint64_t next_ns;
+    bool sent;
+    uint8_t last[256];
+} subscription;
+
+typedef struct {
+    int fd;
+    subscription subs[MAX_SUBS];
+    size_t nsubs;
+} client;
+
+typedef struct {
+    client* c;
+    size_t payload;
+    axp_proto_msg msg;
+} pending;
+
+static axp_i2c_dev dev;
+static uint8_t cache[256];
+static uint64_t fetched_ns[256];     // 0 = nicht im Cache
+static uint32_t ttl_ms[256];
+static client clients[MAX_CLIENTS];
+static pending queue[MAX_PENDING];
+
+static volatile sig_atomic_t stop_requested;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Status, IRQ, ADC and fuel-gauge registers change on their own; the
+// configuration registers only change when someone writes them.
+static bool is_volatile(uint8_t reg) {
+    return reg <= 0x01 || (reg >= 0x48 && reg <= 0x4C) || (reg >= 0x56 && reg <= 0x5F) ||
+           (reg >= 0x78 && reg <= 0x7D) || (reg >= 0xB0 && reg <= 0xB9);
+}
+
+// ==========================
+// Cache
+// ==========================
+
+// Age limit per register for one round; UINT32_MAX = not requested
+static uint32_t need_ms[256];
+
+static void need_reset(void) {
+    for (int r = 0; r < 256; ++r)
+        need_ms[r] = UINT32_MAX;
+}
+
+static void need_add(uint8_t reg, uint16_t max_age_ms) {
+    uint32_t age = max_age_ms == AXP_PROTO_SERVER_TTL ? ttl_ms[reg]
+                 : max_age_ms < ttl_ms[reg] ? max_age_ms : ttl_ms[reg];
+    if (age < need_ms[reg])
+        need_ms[reg] = age;
+}
+
+// Fetch every requested register that is older than its limit with one
+// planned read. Filler bytes read along the way refresh the cache too.
+static int cache_refresh(uint64_t now) {
+    uint8_t stale[256];
+    size_t nstale = 0;
+
+    for (int r = 0; r < 256; ++r) {
+        if (need_ms[r] == UINT32_MAX)
+            continue;
+        if (!fetched_ns[r] || now - fetched_ns[r] > (uint64_t)need_ms[r] * 1000000ull)
+            stale[nstale++] = r;
+    }
+    if (nstale == 0)
+        return 0;
+
+    axp_i2c_span spans[AXP_I2C_MAX_SPANS];
+    size_t nspans = axp_i2c_plan_reads(stale, nstale, axp_i2c_plan_gap(&dev, AXP_I2C_DEFAULT_GAP), spans, AXP_I2C_MAX_SPANS);
+    axp_snapshot snap;
+    int ret = axp_snapshot_read(&dev, &snap, spans, nspans);
+    int err = errno;
+
+    for (int r = 0; r < 256; ++r) {
+        if (axp_snapshot_is_valid(&snap, r)) {
+            cache[r] = snap.reg[r];
+            fetched_ns[r] = now;
+        }
+    }
+    errno = err;
+    return ret;
+}
+
+static bool cache_fresh(uint8_t reg, uint64_t now) {
+    return fetched_ns[reg] && now - fetched_ns[reg] <= (uint64_t)need_ms[reg] * 1000000ull;
+}
+
+// Write-through: keep what we wrote, except where the chip does not simply
+// store the value (read-only, write-1-to-clear) - those are re-read.
+static void cache_written(uint8_t reg, uint8_t val, bool ok, uint64_t now) {
+    if (ok && !is_volatile(reg)) {
+        cache[reg] = val;
+        fetched_ns[reg] = now;
+    } else {
+        fetched_ns[reg] = 0;
+    }
+}
+
+// ==========================
+// Requests
+// ==========================
+
+static void client_close(client* c) {
+    close(c->fd);
+    c->fd = -1;
+    c->nsubs = 0;
+}
+
+static void reply(client* c, axp_proto_msg* msg, int status, size_t payload) {
+    msg->hdr.status = status;
+    if (c->fd >= 0 && send(c->fd, msg, sizeof(msg->hdr) + payload, MSG_DONTWAIT | MSG_NOSIGNAL) < 0)
+        client_close(c);    // Client liest nicht mehr mit
+}
+
+static int validate(const pending* p) {
+    const axp_proto_hdr* h = &p->msg.hdr;
+    unsigned end = h->reg + h->count;
+
+    switch (h->op) {
+    case AXP_OP_READ:
+    case AXP_OP_SUBSCRIBE:
+        if (h->count == 0 || end > 256 || p->payload != 0)
+            return EINVAL;
+        if (h->op == AXP_OP_SUBSCRIBE && h->max_age_ms == 0)
+            return EINVAL;
+        return 0;
+    case AXP_OP_WRITE:
+        return h->count == 0 || end > 256 || p->payload != h->count ? EINVAL : 0;
+    case AXP_OP_READ_LIST:
+        return h->count == 0 || h->count > 256 || p->payload != h->count ? EINVAL : 0;
+    case AXP_OP_WRITE_LIST:
+        return h->count == 0 || h->count > 256 || p->payload != 2u * h->count ? EINVAL : 0;
+    case AXP_OP_UNSUBSCRIBE:
+        return 0;
+    default:
+        return EOPNOTSUPP;
+    }
+}
+
+// Collect the read demand of one request
+static void request_needs(const pending* p) {
+    const axp_proto_hdr* h = &p->msg.hdr;
+    if (h->op == AXP_OP_READ)
+        for (unsigned i = 0; i < h->count; ++i)
+            need_add(h->reg + i, h->max_age_ms);
+    else if (h->op == AXP_OP_READ_LIST)
+        for (unsigned i = 0; i < h->count; ++i)
+            need_add(p->msg.data[i], h->max_age_ms);
+}
+
+static int serve_reads(const uint8_t* regs, size_t count, uint8_t* out, uint64_t now) {
+    // Ein Write in derselben Runde kann Register invalidiert haben
+    for (size_t i = 0; i < count; ++i) {
+        if (!cache_fresh(regs[i], now)) {
+            if (cache_refresh(now) < 0)
+                return errno ? errno : EIO;
+            break;
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (!cache_fresh(regs[i], now))
+            return EIO;
+        out[i] = cache[regs[i]];
+    }
+    return 0;
+}
+
+static int serve_writes(const uint8_t* regs, const uint8_t* values, size_t count, uint64_t now) {
+    int ret = axp_i2c_write_regs(&dev, regs, values, count);
+    int err = errno;
+    for (size_t i = 0; i < count; ++i)
+        cache_written(regs[i], values[i], ret == 0, now);
+    return ret < 0 ? (err ? err : EIO) : 0;
+}
+
+static void execute(pending* p, uint64_t now) {
+    axp_proto_msg* msg = &p->msg;
+    axp_proto_hdr* h = &msg->hdr;
+    uint8_t regs[256], values[256];
+    int status = validate(p);
+    size_t out = 0;
+
+    if (status == 0) {
+        switch (h->op) {
+        case AXP_OP_READ:
+            for (unsigned i = 0; i < h->count; ++i)
+                regs[i] = h->reg + i;
+            status = serve_reads(regs, h->count, msg->data, now);
+            out = status ? 0 : h->count;
+            break;
+        case AXP_OP_READ_LIST:
+            memcpy(regs, msg->data, h->count);
+            status = serve_reads(regs, h->count, msg->data, now);
+            out = status ? 0 : h->count;
+            break;
+        case AXP_OP_WRITE:
+            for (unsigned i = 0; i < h->count; ++i)
+                regs[i] = h->reg + i;
+            status = serve_writes(regs, msg->data, h->count, now);
+            break;
+        case AXP_OP_WRITE_LIST:
+            for (unsigned i = 0; i < h->count; ++i) {
+                regs[i] = msg->data[2 * i];
+                values[i] = msg->data[2 * i + 1];
+            }
+            status = serve_writes(regs, values, h->count, now);
+            break;
+        case AXP_OP_SUBSCRIBE:
+            if (p->c->nsubs == MAX_SUBS) {
+                status = ENOSPC;
+                break;
+            }
+            p->c->subs[p->c->nsubs++] = (subscription){
+                .reg = h->reg, .count = h->count, .interval_ms = h->max_age_ms, .next_ns = now,
+            };
+            break;
+        case AXP_OP_UNSUBSCRIBE:
+            p->c->nsubs = 0;
+            break;
+        }
+    }
+    reply(p->c, msg, status, out);
+}
+
+// ==========================
+// Subscriptions
+// ==========================
+
+static void serve_subscriptions(uint64_t now) {
+    bool due = false;
+    need_reset();
+    for (int i = 0; i < MAX_CLIENTS; ++i) {
+        client* c = &clients[i];
+        for (size_t s = 0; c->fd >= 0 && s < c->nsubs; ++s) {
+            subscription* sub = &c->subs[s];
+            if (sub->next_ns > now)
+                continue;
+            for (unsigned k = 0; k < sub->count; ++k)
+                need_add(sub->reg + k, sub->interval_ms);
+            due = true;
+        }
+    }
+    if (!due)
+        return;
+    cache_refresh(now);
+
+    for (int i = 0; i < MAX_CLIENTS; ++i) {
+        client* c = &clients[i];
+        for (size_t s = 0; c->fd >= 0 && s < c->nsubs; ++s) {
+            subscription* sub = &c->subs[s];
+            if (sub->next_ns > now)
+                continue;
+            uint64_t interval = (uint64_t)sub->interval_ms * 1000000ull;
+            sub->next_ns += interval;
+            if (sub->next_ns <= now)
+                sub->next_ns = now + interval;   // nicht aufholen
+
+            bool fresh = true;
+            for (unsigned k = 0; k < sub->count; ++k)
+                fresh = fresh && cache_fresh(sub->reg + k, now);
+            if (!fresh || (sub->sent && memcmp(sub->last, &cache[sub->reg], sub->count) == 0))
+                continue;
+
+            memcpy(sub->last, &cache[sub->reg], sub->count);
+            sub->sent = true;
+            axp_proto_msg ev = { .hdr = { .op = AXP_OP_EVENT, .reg = sub->reg, .count = sub->count } };
+            memcpy(ev.data, sub->last, sub->count);
+            if (send(c->fd, &ev, sizeof(ev.hdr) + sub->count, MSG_DONTWAIT | MSG_NOSIGNAL) < 0 &&
+                errno != EAGAIN)
+                client_close(c);
+        }
+    }
+}
+
+static int next_timeout_ms(uint64_t now) {
+    uint64_t next = UINT64_MAX;
+    for (int i = 0; i < MAX_CLIENTS; ++i)
+        for (size_t s = 0; clients[i].fd >= 0 && s < clients[i].nsubs; ++s)
+            if (clients[i].subs[s].next_ns < next)
+                next = clients[i].subs[s].next_ns;
+    if (next == UINT64_MAX)
+        return -1;
+    return next <= now ? 0 : (int)((next - now + 999999) / 1000000);
+}
+
+// ==========================
+// Main
+// ==========================
+
+static int listen_socket(const char* path) {
+    struct sockaddr_un sa = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(sa.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(sa.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+    unlink(path);
+    if (bind(fd, (struct sockaddr*)&sa, sizeof(sa)) < 0 || chmod(path, 0660) < 0 ||
+        listen(fd, MAX_CLIENTS) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <i2c-bus|sim[:opts]> <device-hex> [--socket=PATH] "
+                        "[--ttl=MS] [--ttl-volatile=MS]\n", argv[0]);
+        return 1;
+    }
+
+    const char* bus = argv[1];
+    int addr = (int)strtol(argv[2], NULL, 16);
+    const char* sock_path = AXP_PROTO_DEFAULT_SOCKET;
+    uint32_t ttl = DEFAULT_TTL_MS, ttl_volatile = DEFAULT_VOLATILE_TTL_MS;
+
+    for (int i = 3; i < argc; ++i) {
+        if (strncmp(argv[i], "--socket=", 9) == 0) {
+            sock_path = argv[i] + 9;
+        } else if (strncmp(argv[i], "--ttl=", 6) == 0) {
+            ttl = strtoul(argv[i] + 6, NULL, 10);
+        } else if (strncmp(argv[i], "--ttl-volatile=", 15) == 0) {
+            ttl_volatile = strtoul(argv[i] + 15, NULL, 10);
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (axp_proto_is_path(bus)) {
+        fprintf(stderr, "axpd cannot use itself as bus\n");
+        return 1;
+    }
+    for (int r = 0; r < 256; ++r)
+        ttl_ms[r] = is_volatile(r) ? ttl_volatile : ttl;
+
+    if (axp_i2c_open(&dev, bus, addr) < 0) {
+        perror("Open I2C bus failed");
+        return 1;
+    }
+    int lfd = listen_socket(sock_path);
+    if (lfd < 0) {
+        perror("Listen on socket failed");
+        axp_i2c_close(&dev);
+        return 1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    for (int i = 0; i < MAX_CLIENTS; ++i)
+        clients[i].fd = -1;
+
+    fprintf(stderr, "axpd: serving device 0x%02X on %s (%s) via %s\n", addr, bus,
+            axp_i2c_access_name(&dev), sock_path);
+
+    while (!stop_requested) {
+        struct pollfd pfds[MAX_CLIENTS + 1];
+        client* owners[MAX_CLIENTS + 1];
+        nfds_t n = 0;
+        pfds[n++] = (struct pollfd){ .fd = lfd, .events = POLLIN };
+        for (int i = 0; i < MAX_CLIENTS; ++i) {
+            if (clients[i].fd >= 0) {
+                owners[n] = &clients[i];
+                pfds[n++] = (struct pollfd){ .fd = clients[i].fd, .events = POLLIN };
+            }
+        }
+
+        if (poll(pfds, n, next_timeout_ms(monotonic_ns())) < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("poll failed");
+            break;
+        }
+
+        if (pfds[0].revents & POLLIN) {
+            int cfd = accept(lfd, NULL, NULL);
+            int slot = -1;
+            for (int i = 0; cfd >= 0 && i < MAX_CLIENTS && slot < 0; ++i)
+                if (clients[i].fd < 0)
+                    slot = i;
+            if (slot >= 0) {
+                clients[slot].fd = cfd;
+                clients[slot].nsubs = 0;
+            } else if (cfd >= 0) {
+                close(cfd);     // voll
+            }
+        }
+
+        // Runde 1: Requests aller Clients einsammeln
+        size_t npending = 0;
+        for (nfds_t i = 1; i < n; ++i) {
+            if (!pfds[i].revents)
+                continue;
+            client* c = owners[i];
+            for (int k = 0; k < RECV_PER_ROUND && npending < MAX_PENDING; ++k) {
+                pending* p = &queue[npending];
+                ssize_t len = recv(c->fd, &p->msg, sizeof(p->msg), MSG_DONTWAIT);
+                if (len < 0 && errno == EAGAIN)
+                    break;
+                if (len <= 0) {
+                    client_close(c);
+                    break;
+                }
+                if (len < (ssize_t)sizeof(p->msg.hdr)) {
+                    axp_proto_msg bad = { .hdr = { 0 } };
+                    reply(c, &bad, EPROTO, 0);
+                    continue;
+                }
+                p->c = c;
+                p->payload = len - sizeof(p->msg.hdr);
+                npending++;
+            }
+        }
+
+        // Runde 2: alle veralteten Register in einem Bus-Zugriff holen
+        uint64_t now = monotonic_ns();
+        if (npending) {
+            need_reset();
+            for (size_t i = 0; i < npending; ++i)
+                if (validate(&queue[i]) == 0)
+                    request_needs(&queue[i]);
+            cache_refresh(now);
+
+            // Runde 3: in Ankunftsreihenfolge beantworten
+            for (size_t i = 0; i < npending; ++i) {
+                if (queue[i].c->fd < 0)
+                    continue;
+                need_reset();
+                request_needs(&queue[i]);
+                execute(&queue[i], now);
+            }
+        }
+
+        serve_subscriptions(monotonic_ns());
+    }
+
+    for (int i = 0; i < MAX_CLIENTS; ++i)
+        if (clients[i].fd >= 0)
+            client_close(&clients[i]);
+    close(lfd);
+    unlink(sock_path);
+    axp_i2c_close(&dev);
+    return 0;
+}
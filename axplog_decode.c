@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "axp223_log.h"
+#include "axp223_energy.h"
+#include "axp223_capture.h"
+#include "axp223_adc.h"
+
+// ==========================
+// Offline-Decoder fuer AXP223 Sample-Logs
+// ==========================
+// Converts a binary log written by `i2cread_axp --log=FILE` into CSV
+// (time, mV, mA, mA, degC) or prints a min/max/mean summary. Given the
+// state file of `i2cread_axp --energy=FILE` it prints the accumulators;
+// given a capture of `i2cread_axp --capture=FILE` it prints every event
+// window relative to its trigger.
+
+// Records per batch conversion; the arrays stay in L1/L2
+#define CHUNK 1024
+
+// nAh/nWh -> mAh/mWh with three decimals
+static void print_milli(const char* key, int64_t nano) {
+    printf("%s=%lld.%03lld\n", key, (long long)(nano / 1000000), (long long)(nano / 1000 % 1000));
+}
+
+static void print_energy(const axp_energy_state* map) {
+    axp_energy_state st;
+    axp_energy_read(map, &st);
+    print_milli("charge_in_mAh", st.charge_nah[AXP_ENERGY_IN]);
+    print_milli("charge_out_mAh", st.charge_nah[AXP_ENERGY_OUT]);
+    print_milli("energy_in_mWh", st.energy_nwh[AXP_ENERGY_IN]);
+    print_milli("energy_out_mWh", st.energy_nwh[AXP_ENERGY_OUT]);
+    printf("integrated_s=%llu.%03llu\n", (unsigned long long)(st.integrated_ns / 1000000000ull),
+           (unsigned long long)(st.integrated_ns / 1000000 % 1000));
+    printf("samples=%llu\ngaps=%llu\nupdated_unix_ns=%llu\n", (unsigned long long)st.samples,
+           (unsigned long long)st.gaps, (unsigned long long)st.updated_unix_ns);
+}
+
+// 0.1-Einheiten als "123.4" / "-0.5"
+static const char* dec1(char* buf, int32_t v) {
+    uint32_t a = v < 0 ? -(uint32_t)v : (uint32_t)v;
+    snprintf(buf, 16, "%s%u.%u", v < 0 ? "-" : "", a / 10, a % 10);
+    return buf;
+}
+
+// CSV rows for `n` records; `prefix` starts every row, times are relative
+// to `t0_ns`
+static void print_rows(const axp_log_record* rec, size_t n, const char* prefix, uint64_t t0_ns) {
+    static int32_t val[AXP_ADC_CHANNELS][CHUNK];
+    int32_t* const out[AXP_ADC_CHANNELS] = { val[0], val[1], val[2], val[3] };
+    axp_adc_stats st[AXP_ADC_CHANNELS];
+    char b[AXP_ADC_CHANNELS][16];
+
+    for (size_t done = 0; done < n; done += CHUNK) {
+        size_t m = n - done < CHUNK ? n - done : CHUNK;
+        for (int c = 0; c < AXP_ADC_CHANNELS; ++c)
+            axp_adc_stats_init(&st[c]);
+        axp_adc_convert_records(rec + done, m, out, st);
+        for (size_t i = 0; i < m; ++i)
+            printf("%s%.6f,%s,%s,%s,%s\n", prefix, ((int64_t)rec[done + i].t_ns - (int64_t)t0_ns) / 1e9,
+                   dec1(b[0], val[AXP_ADC_CH_VBAT][i]), dec1(b[1], val[AXP_ADC_CH_ICHG][i]),
+                   dec1(b[2], val[AXP_ADC_CH_IDIS][i]), dec1(b[3], val[AXP_ADC_CH_TEMP][i]));
+    }
+}
+
+// CSV with one row per sample, or one line per event with --summary
+static int print_capture(const uint8_t* map, size_t size, bool summary) {
+    const axp_capture_header* hdr = (const axp_capture_header*)map;
+    if (hdr->version != AXP_CAPTURE_VERSION || hdr->event_size != sizeof(axp_capture_event) ||
+        hdr->record_size != sizeof(axp_log_record)) {
+        fprintf(stderr, "unsupported capture version\n");
+        return 1;
+    }
+    if (summary)
+        printf("Device      : 0x%02X @ %u Hz, pre %u, post %u, trigger 48..4C = %02X %02X %02X %02X %02X\n",
+               hdr->dev_addr, hdr->rate_hz, hdr->pre, hdr->post, hdr->trigger[0], hdr->trigger[1],
+               hdr->trigger[2], hdr->trigger[3], hdr->trigger[4]);
+    else
+        printf("event,t_rel_s,battery_mV,charge_mA,discharge_mA,temp_C\n");
+
+    size_t off = hdr->header_size;
+    unsigned n = 0;
+    // Ein abgeschnittenes letztes Event (Absturz waehrend write) wird ignoriert
+    while (off + sizeof(axp_capture_event) <= size) {
+        const axp_capture_event* ev = (const axp_capture_event*)(map + off);
+        size_t count = (size_t)ev->pre_count + 1 + ev->post_count;
+        if (off + sizeof(*ev) + count * sizeof(axp_log_record) > size)
+            break;
+        const axp_log_record* rec = (const axp_log_record*)(map + off + sizeof(*ev));
+        off += sizeof(*ev) + count * sizeof(axp_log_record);
+        n++;
+
+        if (summary) {
+            int32_t at[AXP_ADC_CHANNELS];
+            int32_t* const out[AXP_ADC_CHANNELS] = { &at[0], &at[1], &at[2], &at[3] };
+            axp_adc_stats st[AXP_ADC_CHANNELS];
+            char b[3][16];
+            for (int c = 0; c < AXP_ADC_CHANNELS; ++c)
+                axp_adc_stats_init(&st[c]);
+            axp_adc_convert_records(&rec[ev->pre_count], 1, out, st);
+            printf("Event %-6u: t %.6f s, irq %02X %02X %02X %02X %02X, %u+1+%u samples, "
+                   "%u read errors, %s mV %s mA %s mA at trigger\n",
+                   n, (ev->t_ns - hdr->start_ns) / 1e9, ev->irq[0], ev->irq[1], ev->irq[2],
+                   ev->irq[3], ev->irq[4], ev->pre_count, ev->post_count, ev->read_errors,
+                   dec1(b[0], at[AXP_ADC_CH_VBAT]), dec1(b[1], at[AXP_ADC_CH_ICHG]),
+                   dec1(b[2], at[AXP_ADC_CH_IDIS]));
+            continue;
+        }
+        char prefix[16];
+        snprintf(prefix, sizeof(prefix), "%u,", n);
+        print_rows(rec, count, prefix, ev->t_ns);
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 3 || (argc == 3 && strcmp(argv[2], "--summary") != 0)) {
+        fprintf(stderr, "Usage: %s <log-file|capture-file> [--summary]\n       %s <energy-state>\n",
+                argv[0], argv[0]);
+        return 1;
+    }
+    bool summary = argc == 3;
+
+    int fd = open(argv[1], O_RDONLY);
+    if (fd < 0) {
+        perror("Open log file failed");
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(axp_log_header)) {
+        fprintf(stderr, "%s: not an AXP223 sample log\n", argv[1]);
+        close(fd);
+        return 1;
+    }
+    const uint8_t* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap log file failed");
+        return 1;
+    }
+    madvise((void*)map, st.st_size, MADV_SEQUENTIAL);
+
+    if ((size_t)st.st_size == sizeof(axp_energy_state) &&
+        memcmp(map, AXP_ENERGY_MAGIC, sizeof(AXP_ENERGY_MAGIC)) == 0) {
+        print_energy((const axp_energy_state*)map);
+        munmap((void*)map, st.st_size);
+        return 0;
+    }
+
+    if (memcmp(map, AXP_CAPTURE_MAGIC, sizeof(AXP_CAPTURE_MAGIC)) == 0) {
+        int ret = print_capture(map, st.st_size, summary);
+        munmap((void*)map, st.st_size);
+        return ret;
+    }
+
+    const axp_log_header* hdr = (const axp_log_header*)map;
+    if (memcmp(hdr->magic, AXP_LOG_MAGIC, sizeof(AXP_LOG_MAGIC)) != 0 ||
+        hdr->version != AXP_LOG_VERSION || hdr->record_size != sizeof(axp_log_record)) {
+        fprintf(stderr, "%s: not an AXP223 sample log (or unsupported version)\n", argv[1]);
+        return 1;
+    }
+
+    // Nicht mehr Records lesen, als tatsaechlich in der Datei stehen
+    // (z.B. nach einem Absturz vor axp_log_close)
+    uint64_t count = hdr->record_count;
+    uint64_t fits = (st.st_size - hdr->header_size) / sizeof(axp_log_record);
+    if (count > fits)
+        count = fits;
+
+    const axp_log_record* rec = (const axp_log_record*)(map + hdr->header_size);
+
+    static char outbuf[1 << 16];
+    setvbuf(stdout, outbuf, _IOFBF, sizeof(outbuf));
+    if (!summary)
+        printf("t_s,battery_mV,charge_mA,discharge_mA,temp_C\n");
+
+    if (!summary) {
+        print_rows(rec, count, "", hdr->start_ns);
+    } else {
+        // Nur Statistik: keine Ausgabearrays, ein Durchlauf ueber die Datei
+        static const char* names[] = { "Battery Voltage (mV)", "Charge Current (mA)",
+                                       "Discharge Current (mA)", "Temperature (C)" };
+        int32_t* const none[AXP_ADC_CHANNELS] = { NULL, NULL, NULL, NULL };
+        axp_adc_stats stats[AXP_ADC_CHANNELS];
+        for (int c = 0; c < AXP_ADC_CHANNELS; ++c)
+            axp_adc_stats_init(&stats[c]);
+        axp_adc_convert_records(rec, count, none, stats);
+
+        double span_s = count ? (rec[count - 1].t_ns - rec[0].t_ns) / 1e9 : 0;
+        printf("Records     : %llu (%llu read errors)\n",
+               (unsigned long long)count, (unsigned long long)hdr->read_errors);
+        printf("Device      : 0x%02X @ %u Hz, %.3f s\n", hdr->dev_addr, hdr->rate_hz, span_s);
+        for (int c = 0; c < AXP_ADC_CHANNELS && count; ++c) {
+            char lo[16], hi[16];
+            printf("%-23s: min %s  max %s  mean %.2f\n", names[c], dec1(lo, stats[c].min),
+                   dec1(hi, stats[c].max), stats[c].sum / 10.0 / count);
+        }
+    }
+
+    munmap((void*)map, st.st_size);
+    return 0;
+}
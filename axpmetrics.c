@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "axp223_metrics.h"
+
+// ==========================
+// Metrik-Exporter
+// ==========================
+// Prints a metrics segment (AXP_METRICS=<file> of the other tools) in the
+// Prometheus text format, e.g. for node_exporter's textfile collector or a
+// small HTTP wrapper. Reads only the mapping, never the bus.
+
+static uint64_t get(const _Atomic uint64_t* c) {
+    return atomic_load_explicit((_Atomic uint64_t*)c, memory_order_relaxed);
+}
+
+static void counter(const char* name, const char* help, uint64_t v) {
+    printf("# HELP %s %s\n# TYPE %s counter\n%s %llu\n", name, help, name, name, (unsigned long long)v);
+}
+
+int main(int argc, char* argv[]) {
+    const char* path = argc > 1 ? argv[1] : getenv(AXP_METRICS_ENV);
+    if (argc > 2 || !path) {
+        fprintf(stderr, "Usage: %s <metrics-file>   (default: $%s)\n", argv[0], AXP_METRICS_ENV);
+        return 1;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("Open metrics file failed");
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size != sizeof(axp_metrics)) {
+        fprintf(stderr, "%s: not an AXP223 metrics segment\n", path);
+        close(fd);
+        return 1;
+    }
+    const axp_metrics* m = mmap(NULL, sizeof(axp_metrics), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED) {
+        perror("mmap metrics file failed");
+        return 1;
+    }
+    if (memcmp(m->magic, AXP_METRICS_MAGIC, sizeof(AXP_METRICS_MAGIC)) != 0 ||
+        m->version != AXP_METRICS_VERSION) {
+        fprintf(stderr, "%s: not an AXP223 metrics segment (or unsupported version)\n", path);
+        return 1;
+    }
+
+    static char outbuf[1 << 16];
+    setvbuf(stdout, outbuf, _IOFBF, sizeof(outbuf));
+
+    counter("axp_i2c_transactions_total", "I2C_RDWR transactions", get(&m->xfers));
+    counter("axp_i2c_messages_total", "I2C messages in all transactions", get(&m->msgs));
+    counter("axp_i2c_bytes_total", "Payload bytes on the bus", get(&m->bytes));
+    counter("axp_i2c_transaction_errors_total", "Failed transactions", get(&m->xfer_errors));
+
+    printf("# HELP axp_i2c_errors_total Failed transactions by errno class\n"
+           "# TYPE axp_i2c_errors_total counter\n");
+    for (int c = 0; c < AXP_ERR_CLASSES; ++c)
+        printf("axp_i2c_errors_total{class=\"%s\"} %llu\n", axp_err_class_names[c],
+               (unsigned long long)get(&m->err_class[c]));
+
+    // Log2-Buckets als kumulatives Histogramm in Sekunden
+    printf("# HELP axp_i2c_latency_seconds Transaction latency\n"
+           "# TYPE axp_i2c_latency_seconds histogram\n");
+    uint64_t cum = 0;
+    for (int b = 0; b < AXP_METRICS_BUCKETS; ++b) {
+        cum += get(&m->latency_hist[b]);
+        if (b == AXP_METRICS_BUCKETS - 1)
+            break;
+        uint64_t le_ns = 2ull << b;
+        printf("axp_i2c_latency_seconds_bucket{le=\"%llu.%09llu\"} %llu\n",
+               (unsigned long long)(le_ns / 1000000000ull), (unsigned long long)(le_ns % 1000000000ull),
+               (unsigned long long)cum);
+    }
+    uint64_t sum = get(&m->latency_sum_ns);
+    printf("axp_i2c_latency_seconds_bucket{le=\"+Inf\"} %llu\n", (unsigned long long)cum);
+    printf("axp_i2c_latency_seconds_sum %llu.%09llu\n",
+           (unsigned long long)(sum / 1000000000ull), (unsigned long long)(sum % 1000000000ull));
+    printf("axp_i2c_latency_seconds_count %llu\n", (unsigned long long)cum);
+    uint64_t max = get(&m->latency_max_ns);
+    printf("# HELP axp_i2c_latency_max_seconds Slowest transaction\n"
+           "# TYPE axp_i2c_latency_max_seconds gauge\n"
+           "axp_i2c_latency_max_seconds %llu.%09llu\n",
+           (unsigned long long)(max / 1000000000ull), (unsigned long long)(max % 1000000000ull));
+
+    // Nur Register mit Verkehr
+    static const char* const kinds[] = { "read", "write", "error" };
+    printf("# HELP axp_register_accesses_total Register bytes read/written, failed accesses\n"
+           "# TYPE axp_register_accesses_total counter\n");
+    for (int r = 0; r < 256; ++r) {
+        uint64_t v[3] = { get(&m->reg[r].reads), get(&m->reg[r].writes), get(&m->reg[r].errors) };
+        for (int k = 0; k < 3; ++k)
+            if (v[k])
+                printf("axp_register_accesses_total{reg=\"0x%02X\",kind=\"%s\"} %llu\n",
+                       r, kinds[k], (unsigned long long)v[k]);
+    }
+
+    munmap((void*)m, sizeof(axp_metrics));
+    return 0;
+}
@@ -0,0 +1,382 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/timerfd.h>
+#include "axp223_i2c.h"
+#include "axp223_decode.h"
+#include "axp223_regs.h"
+
+// ==========================
+// Multi-Bus-Poller
+// ==========================
+// Polls a list of devices (bus path, address, register plan) in sweeps. One
+// worker thread per adapter reads that adapter's devices one after the
+// other, each with its planned block reads; different adapters run in
+// parallel. After every sweep the main thread merges all results into one
+// timestamped record stream, so a sweep takes as long as the busiest
+// adapter instead of the sum of all devices.
+//
+// Device list, one per line ('#' comments):
+//   <bus> <addr-hex> table|adc|<reg>[-<reg>][,...]
+// "table" is the register table of i2cread_axp_full, "adc" the battery and
+// temperature ADC registers.
+
+#define MAX_DEVICES 32
+#define MAX_BUSES   16
+
+typedef struct {
+    char bus[64];
+    uint8_t addr;
+    uint8_t regs[256];
+    size_t nregs;
+    uint32_t planned[256 / 32];
+    axp_i2c_span spans[AXP_I2C_MAX_SPANS];
+    size_t nspans;
+    axp_i2c_dev dev;
+
+    // Ergebnis der aktuellen Runde (vom Worker geschrieben)
+    axp_snapshot snap;
+    uint64_t t_ns;
+    uint64_t read_ns;
+    bool ok;
+} device;
+
+typedef struct {
+    const char* bus;
+    device* devs[MAX_DEVICES];
+    size_t ndevs;
+    pthread_t thread;
+} bus_worker;
+
+static device devices[MAX_DEVICES];
+static size_t ndevices;
+static bus_worker workers[MAX_BUSES];
+static size_t nworkers;
+
+static pthread_barrier_t sweep_start, sweep_done;
+static _Atomic int stopping;
+static volatile sig_atomic_t stop_requested;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// ==========================
+// Geraeteliste
+// ==========================
+
+static int parse_regs(device* d, const char* spec) {
+    bool seen[256] = { false };
+    d->nregs = 0;
+
+    if (strcmp(spec, "table") == 0) {
+        for (size_t i = 0; i < REGISTER_COUNT; ++i)
+            d->regs[d->nregs++] = registers[i].address;
+        return 0;
+    }
+    if (strcmp(spec, "adc") == 0)
+        spec = "56-57,78-7D";
+
+    const char* p = spec;
+    while (*p) {
+        char* end;
+        unsigned long first = strtoul(p, &end, 16), last = first;
+        if (end == p || first > 0xFF)
+            return -1;
+        if (*end == '-') {
+            p = end + 1;
+            last = strtoul(p, &end, 16);
+            if (end == p || last > 0xFF || last < first)
+                return -1;
+        }
+        for (unsigned long r = first; r <= last; ++r) {
+            if (!seen[r]) {
+                seen[r] = true;
+                d->regs[d->nregs++] = r;
+            }
+        }
+        if (*end == ',')
+            end++;
+        else if (*end)
+            return -1;
+        p = end;
+    }
+    return d->nregs ? 0 : -1;
+}
+
+static int parse_devices(FILE* f, const char* name) {
+    char line[512];
+    int lineno = 0;
+
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        char* hash = strchr(line, '#');
+        if (hash)
+            *hash = '\0';
+
+        char bus[64], addr[16], regs[384];
+        int n = sscanf(line, "%63s %15s %383s", bus, addr, regs);
+        if (n <= 0)
+            continue;
+        if (n != 3) {
+            fprintf(stderr, "%s:%d: expected <bus> <addr-hex> <registers>\n", name, lineno);
+            return -1;
+        }
+        if (ndevices == MAX_DEVICES) {
+            fprintf(stderr, "%s:%d: more than %d devices\n", name, lineno, MAX_DEVICES);
+            return -1;
+        }
+
+        device* d = &devices[ndevices];
+        snprintf(d->bus, sizeof(d->bus), "%s", bus);
+        d->addr = (uint8_t)strtoul(addr, NULL, 16);
+        if (parse_regs(d, regs) < 0) {
+            fprintf(stderr, "%s:%d: invalid register list '%s'\n", name, lineno, regs);
+            return -1;
+        }
+        ndevices++;
+    }
+    return 0;
+}
+
+// Geraete nach Bus gruppieren, Reihenfolge der Liste bleibt erhalten
+static int assign_workers(void) {
+    for (size_t i = 0; i < ndevices; ++i) {
+        bus_worker* w = NULL;
+        for (size_t k = 0; k < nworkers && !w; ++k)
+            if (strcmp(workers[k].bus, devices[i].bus) == 0)
+                w = &workers[k];
+        if (!w) {
+            if (nworkers == MAX_BUSES) {
+                fprintf(stderr, "More than %d buses\n", MAX_BUSES);
+                return -1;
+            }
+            w = &workers[nworkers++];
+            w->bus = devices[i].bus;
+        }
+        w->devs[w->ndevs++] = &devices[i];
+    }
+    return 0;
+}
+
+// ==========================
+// Worker
+// ==========================
+
+static void* worker_main(void* arg) {
+    bus_worker* w = arg;
+    for (;;) {
+        pthread_barrier_wait(&sweep_start);
+        if (atomic_load(&stopping))
+            break;
+        for (size_t i = 0; i < w->ndevs; ++i) {
+            device* d = w->devs[i];
+            d->t_ns = monotonic_ns();
+            d->ok = axp_snapshot_read(&d->dev, &d->snap, d->spans, d->nspans) == 0;
+            d->read_ns = monotonic_ns() - d->t_ns;
+        }
+        pthread_barrier_wait(&sweep_done);
+    }
+    return NULL;
+}
+
+// ==========================
+// Ausgabe
+// ==========================
+
+static char out_buf[1 << 18];
+
+static void emit_sweep(axp_out* out, int format, bool decode, uint64_t sweep, uint64_t start_ns) {
+    for (size_t i = 0; i < ndevices; ++i) {
+        device* d = &devices[i];
+        axp_rec rec;
+        axp_rec_begin(&rec, out, format, false);
+        if (axp_rec_key(&rec, NULL, "t_ms"))
+            axp_out_uint(out, (d->t_ns - start_ns) / 1000000);
+        if (axp_rec_key(&rec, NULL, "sweep"))
+            axp_out_uint(out, sweep);
+        if (axp_rec_key(&rec, NULL, "bus"))
+            axp_rec_str(&rec, d->bus);
+        if (axp_rec_key(&rec, NULL, "addr"))
+            axp_out_uint(out, d->addr);
+        if (axp_rec_key(&rec, NULL, "ok"))
+            axp_rec_bool(&rec, d->ok);
+        if (axp_rec_key(&rec, NULL, "read_us"))
+            axp_out_uint(out, d->read_ns / 1000);
+        // nur Eintraege, deren Register im Plan des Geraets liegen
+        for (size_t k = 0; decode && k < AXP_DECODE_COUNT; ++k) {
+            const axp_reg_desc* desc = &axp_decode_table[k];
+            bool covered = true;
+            for (unsigned r = desc->reg; r < (unsigned)desc->reg + desc->nregs; ++r)
+                covered = covered && axp_bitmap_test(d->planned, r);
+            if (covered)
+                axp_rec_decoded(&rec, &d->snap, desc->reg, desc->reg);
+        }
+        axp_rec_registers(&rec, &d->snap, d->regs, d->nregs);
+        axp_rec_end(&rec);
+    }
+    axp_out_flush(out, STDOUT_FILENO);
+}
+
+// ==========================
+// Main
+// ==========================
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <device-list|-> [--rate=HZ] [--count=N] [--gap=N] "
+                        "[--format=json|kv] [--decode]\n", argv[0]);
+        return 1;
+    }
+
+    unsigned rate_hz = 1, gap = AXP_I2C_DEFAULT_GAP;
+    unsigned long count = 0;
+    int format = AXP_FMT_JSON;
+    bool decode = false;
+    for (int i = 2; i < argc; ++i) {
+        if (strncmp(argv[i], "--rate=", 7) == 0) {
+            rate_hz = strtoul(argv[i] + 7, NULL, 10);
+        } else if (strncmp(argv[i], "--count=", 8) == 0) {
+            count = strtoul(argv[i] + 8, NULL, 10);
+        } else if (strncmp(argv[i], "--gap=", 6) == 0) {
+            gap = strtoul(argv[i] + 6, NULL, 10);
+        } else if (strncmp(argv[i], "--format=", 9) == 0) {
+            format = axp_parse_format(argv[i] + 9);
+            if (format != AXP_FMT_JSON && format != AXP_FMT_KV) {
+                fprintf(stderr, "Unsupported format: %s\n", argv[i] + 9);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--decode") == 0) {
+            decode = true;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (rate_hz == 0) {
+        fprintf(stderr, "--rate must be at least 1\n");
+        return 1;
+    }
+
+    FILE* f = strcmp(argv[1], "-") == 0 ? stdin : fopen(argv[1], "r");
+    if (!f) {
+        perror("Open device list failed");
+        return 1;
+    }
+    int parsed = parse_devices(f, argv[1]);
+    if (f != stdin)
+        fclose(f);
+    if (parsed < 0 || assign_workers() < 0)
+        return 1;
+    if (ndevices == 0) {
+        fprintf(stderr, "Device list is empty\n");
+        return 1;
+    }
+
+    for (size_t i = 0; i < ndevices; ++i) {
+        device* d = &devices[i];
+        if (axp_i2c_open(&d->dev, d->bus, d->addr) < 0) {
+            fprintf(stderr, "Open %s for 0x%02X failed: %s\n", d->bus, d->addr, strerror(errno));
+            for (size_t k = 0; k < i; ++k)
+                axp_i2c_close(&devices[k].dev);
+            return 1;
+        }
+        for (size_t k = 0; k < d->nregs; ++k)
+            d->planned[d->regs[k] >> 5] |= 1u << (d->regs[k] & 31);
+        d->nspans = axp_i2c_plan_reads(d->regs, d->nregs, axp_i2c_plan_gap(&d->dev, gap), d->spans, AXP_I2C_MAX_SPANS);
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    int tfd = timerfd_create(CLOCK_MONOTONIC, 0);
+    uint64_t period_ns = 1000000000ull / rate_hz;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    struct itimerspec its = {
+        .it_interval = { period_ns / 1000000000ull, period_ns % 1000000000ull },
+        .it_value = start,
+    };
+    if (tfd < 0 || timerfd_settime(tfd, TFD_TIMER_ABSTIME, &its, NULL) < 0) {
+        perror("timerfd failed");
+        return 1;
+    }
+    uint64_t start_ns = (uint64_t)start.tv_sec * 1000000000ull + start.tv_nsec;
+
+    pthread_barrier_init(&sweep_start, NULL, nworkers + 1);
+    pthread_barrier_init(&sweep_done, NULL, nworkers + 1);
+    for (size_t k = 0; k < nworkers; ++k) {
+        if (pthread_create(&workers[k].thread, NULL, worker_main, &workers[k]) != 0) {
+            fprintf(stderr, "Failed to start worker for %s\n", workers[k].bus);
+            return 1;
+        }
+    }
+    fprintf(stderr, "axppoll: %zu devices on %zu buses, %u Hz\n", ndevices, nworkers, rate_hz);
+    for (size_t k = 0; k < nworkers; ++k)
+        fprintf(stderr, "axppoll: %s via %s\n", workers[k].bus, axp_i2c_access_name(&workers[k].devs[0]->dev));
+
+    axp_out out = { out_buf, 0, sizeof(out_buf) };
+    uint64_t sweeps = 0, sweep_sum = 0, sweep_max = 0, serial_sum = 0, late = 0;
+    while (!stop_requested && (count == 0 || sweeps < count)) {
+        uint64_t ticks;
+        if (read(tfd, &ticks, sizeof(ticks)) != sizeof(ticks)) {
+            if (errno == EINTR)
+                continue;
+            perror("timerfd read failed");
+            break;
+        }
+        late += ticks - 1;
+
+        uint64_t t0 = monotonic_ns();
+        pthread_barrier_wait(&sweep_start);
+        pthread_barrier_wait(&sweep_done);
+        uint64_t dt = monotonic_ns() - t0;
+
+        sweep_sum += dt;
+        if (dt > sweep_max)
+            sweep_max = dt;
+        for (size_t i = 0; i < ndevices; ++i)
+            serial_sum += devices[i].read_ns;
+        emit_sweep(&out, format, decode, sweeps, start_ns);
+        sweeps++;
+    }
+
+    atomic_store(&stopping, 1);
+    pthread_barrier_wait(&sweep_start);
+    for (size_t k = 0; k < nworkers; ++k)
+        pthread_join(workers[k].thread, NULL);
+    for (size_t i = 0; i < ndevices; ++i) {
+        char who[96];
+        snprintf(who, sizeof(who), "axppoll: %.64s 0x%02X", devices[i].bus, devices[i].addr);
+        axp_i2c_report(&devices[i].dev, who);
+        axp_i2c_close(&devices[i].dev);
+    }
+    close(tfd);
+
+    if (sweeps)
+        fprintf(stderr, "axppoll: %llu sweeps, mean %llu us, max %llu us "
+                        "(devices one after another: %llu us), %llu late ticks\n",
+                (unsigned long long)sweeps, (unsigned long long)(sweep_sum / sweeps / 1000),
+                (unsigned long long)(sweep_max / 1000), (unsigned long long)(serial_sum / sweeps / 1000),
+                (unsigned long long)late);
+    return 0;
+}
@@ -0,0 +1,243 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "axp223_i2c.h"
+#include "axp223_decode.h"
+#include "axp223_regs.h"
+#include "axp223_snap.h"
+
+// ==========================
+// Snapshot sichern / vergleichen / zuruecksetzen
+// ==========================
+// save:    all registers 0x00-0xFF in one I2C_RDWR transaction (four 64-byte
+//          block reads, small enough for every adapter) into a snapshot file
+// diff:    two snapshot files, decoded per field where the table knows the
+//          register, bit by bit otherwise
+// restore: read the live registers, then write only the writable registers
+//          that differ, batched into as few transactions as possible
+
+#define SNAP_CHUNK 64
+
+static char out_buf[65536];
+
+static int read_all(axp_i2c_dev* dev, axp_snapshot* snap) {
+    axp_i2c_span spans[256 / SNAP_CHUNK];
+    for (size_t i = 0; i < 256 / SNAP_CHUNK; ++i)
+        spans[i] = (axp_i2c_span){ (uint8_t)(i * SNAP_CHUNK), SNAP_CHUNK };
+    return axp_snapshot_read(dev, snap, spans, 256 / SNAP_CHUNK);
+}
+
+static void to_snapshot(const axp_snap_file* f, axp_snapshot* snap) {
+    memcpy(snap->reg, f->reg, sizeof(snap->reg));
+    memcpy(snap->valid, f->valid, sizeof(snap->valid));
+}
+
+// Registers without a decoder: list of changed bits
+static void render_raw_change(axp_out* o, uint8_t reg, uint8_t before, uint8_t after) {
+    const char* name = register_name(reg);
+    size_t start = o->len;
+    axp_out_str(o, "Register ");
+    axp_out_hex(o, reg, 2);
+    if (name) {
+        axp_out_str(o, " (");
+        axp_out_str(o, name);
+        axp_out_char(o, ')');
+    }
+    axp_out_pad(o, start, AXP_LABEL_WIDTH);
+    axp_out_str(o, ": ");
+    axp_out_hex(o, before, 2);
+    axp_out_str(o, " -> ");
+    axp_out_hex(o, after, 2);
+    axp_out_str(o, "  bits");
+    for (int b = 7; b >= 0; --b) {
+        if (!(((before ^ after) >> b) & 1))
+            continue;
+        axp_out_char(o, ' ');
+        axp_out_uint(o, b);
+        axp_out_char(o, ':');
+        axp_out_char(o, '0' + ((before >> b) & 1));
+        axp_out_str(o, "->");
+        axp_out_char(o, '0' + ((after >> b) & 1));
+    }
+    axp_out_char(o, '\n');
+}
+
+// Render the differences from `a` to `b` restricted to `mask` (NULL: all).
+// Returns the number of differing registers.
+static size_t render_diff(axp_out* o, const axp_snapshot* a, const axp_snapshot* b, const uint32_t* mask) {
+    uint32_t changed[256 / 32];
+    axp_snapshot_diff(a, b, changed);
+    size_t n = 0;
+    for (int w = 0; w < 256 / 32; ++w) {
+        changed[w] &= a->valid[w];      // nur Register, die beide Seiten kennen
+        if (mask)
+            changed[w] &= mask[w];
+        n += __builtin_popcount(changed[w]);
+    }
+
+    axp_render_changes(o, a, b, changed);
+    for (int r = 0; r < 256; ++r)
+        if (axp_bitmap_test(changed, r) && !axp_decode_covers(r))
+            render_raw_change(o, r, a->reg[r], b->reg[r]);
+
+    // Register, die nur eine Seite lesen konnte
+    for (int r = 0; r < 256 && !mask; ++r) {
+        bool in_a = axp_snapshot_is_valid(a, r), in_b = axp_snapshot_is_valid(b, r);
+        if (in_a == in_b)
+            continue;
+        axp_out_str(o, "Register ");
+        axp_out_hex(o, r, 2);
+        axp_out_str(o, in_a ? ": only in first snapshot\n" : ": only in second snapshot\n");
+        n++;
+    }
+    return n;
+}
+
+static int cmd_save(axp_i2c_dev* dev, const char* path) {
+    axp_snapshot snap;
+    if (read_all(dev, &snap) < 0) {
+        perror("Read registers failed");
+        return 1;
+    }
+
+    axp_snap_file f;
+    memset(&f, 0, sizeof(f));
+    memcpy(f.magic, AXP_SNAP_MAGIC, sizeof(AXP_SNAP_MAGIC));
+    f.version = AXP_SNAP_VERSION;
+    f.size = sizeof(f);
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    f.created_unix_ns = (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    f.dev_addr = dev->addr;
+    memcpy(f.reg, snap.reg, sizeof(f.reg));
+    memcpy(f.valid, snap.valid, sizeof(f.valid));
+    for (int r = 0; r < 256; ++r)
+        if (register_writable(r))
+            f.writable[r >> 5] |= 1u << (r & 31);
+
+    if (axp_snap_save(path, &f) < 0) {
+        perror("Write snapshot failed");
+        return 1;
+    }
+    printf("Saved 256 registers of device 0x%02X to %s\n", dev->addr, path);
+    return 0;
+}
+
+static int cmd_diff(const char* path_a, const char* path_b) {
+    axp_snap_file fa, fb;
+    if (axp_snap_load(path_a, &fa) < 0 || axp_snap_load(path_b, &fb) < 0) {
+        perror("Load snapshot failed");
+        return 1;
+    }
+    axp_snapshot a, b;
+    to_snapshot(&fa, &a);
+    to_snapshot(&fb, &b);
+
+    axp_out out = { out_buf, 0, sizeof(out_buf) };
+    size_t n = render_diff(&out, &a, &b, NULL);
+    axp_out_flush(&out, STDOUT_FILENO);
+    return n ? 1 : 0;   // wie diff(1)
+}
+
+static int cmd_restore(axp_i2c_dev* dev, const char* path, bool verify, bool dry_run) {
+    axp_snap_file f;
+    if (axp_snap_load(path, &f) < 0) {
+        perror("Load snapshot failed");
+        return 1;
+    }
+    if (f.dev_addr != dev->addr)
+        fprintf(stderr, "Note: snapshot was taken from device 0x%02X\n", f.dev_addr);
+
+    axp_snapshot live, target;
+    if (read_all(dev, &live) < 0) {
+        perror("Read live registers failed");
+        return 1;
+    }
+    to_snapshot(&f, &target);
+
+    uint32_t mask[256 / 32];
+    for (int w = 0; w < 256 / 32; ++w)
+        mask[w] = f.writable[w] & f.valid[w];
+
+    axp_out out = { out_buf, 0, sizeof(out_buf) };
+    render_diff(&out, &live, &target, mask);
+    axp_out_flush(&out, STDOUT_FILENO);
+
+    uint8_t regs[256], values[256], readback[256];
+    size_t count = 0;
+    for (int r = 0; r < 256; ++r) {
+        if (axp_bitmap_test(mask, r) && live.reg[r] != f.reg[r]) {
+            regs[count] = r;
+            values[count] = f.reg[r];
+            count++;
+        }
+    }
+    if (count == 0) {
+        printf("Device 0x%02X already matches %s\n", dev->addr, path);
+        return 0;
+    }
+    if (dry_run) {
+        printf("%zu registers would be written (dry run)\n", count);
+        return 0;
+    }
+
+    int ret = verify ? axp_i2c_write_verify(dev, regs, values, readback, count)
+                     : axp_i2c_write_regs(dev, regs, values, count);
+    if (ret < 0) {
+        perror("Restore write failed");
+        return 1;
+    }
+    int mismatches = 0;
+    for (size_t i = 0; verify && i < count; ++i) {
+        if (readback[i] != values[i]) {
+            fprintf(stderr, "Verify 0x%02X: wrote 0x%02X, read 0x%02X\n", regs[i], values[i], readback[i]);
+            mismatches++;
+        }
+    }
+    printf("Restored %zu registers on device 0x%02X%s\n", count, dev->addr,
+           verify ? (mismatches ? ", verify FAILED" : ", verified") : "");
+    return mismatches ? 2 : 0;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr, "Usage: %s save <i2c-bus> <device-hex> <file>\n"
+                    "       %s diff <file-a> <file-b>\n"
+                    "       %s restore <i2c-bus> <device-hex> <file> [--verify] [--dry-run]\n",
+            prog, prog, prog);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 4 && strcmp(argv[1], "diff") == 0)
+        return cmd_diff(argv[2], argv[3]);
+
+    bool save = argc == 5 && strcmp(argv[1], "save") == 0;
+    bool restore = argc >= 5 && strcmp(argv[1], "restore") == 0;
+    if (!save && !restore) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    bool verify = false, dry_run = false;
+    for (int i = 5; i < argc; ++i) {
+        if (strcmp(argv[i], "--verify") == 0) {
+            verify = true;
+        } else if (strcmp(argv[i], "--dry-run") == 0) {
+            dry_run = true;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    axp_i2c_dev dev;
+    if (axp_i2c_open(&dev, argv[2], (int)strtol(argv[3], NULL, 16)) < 0) {
+        perror("Open I2C bus failed");
+        return 1;
+    }
+    int ret = save ? cmd_save(&dev, argv[4]) : cmd_restore(&dev, argv[4], verify, dry_run);
+    axp_i2c_close(&dev);
+    return ret;
+}
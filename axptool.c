@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+// ==========================
+// Multi-Call-Binary
+// ==========================
+// All tools in one static executable, busybox style. Each tool is compiled
+// from its own source with -Dmain=<tool>_main and dispatched here by the
+// name it was started as (symlink i2cread_axp -> axptool) or by the first
+// argument (axptool i2cread_axp ...). The tools are compiled with
+// -DAXP_SHARED, so the transaction layer, decoder, simulator, metrics and
+// axpd client come from the one copy in axp223_lib.c (axp223_api.h), and
+// libc is linked once.
+
+typedef int (*applet_main)(int argc, char* argv[]);
+
+int i2cread_main(int argc, char* argv[]);
+int i2cread_axp_main(int argc, char* argv[]);
+int i2cread_axp_full_main(int argc, char* argv[]);
+int i2cset_axp_main(int argc, char* argv[]);
+int axplog_decode_main(int argc, char* argv[]);
+int i2cbench_axp_main(int argc, char* argv[]);
+int axpd_main(int argc, char* argv[]);
+int axpmetrics_main(int argc, char* argv[]);
+int axpsnap_main(int argc, char* argv[]);
+int axppoll_main(int argc, char* argv[]);
+
+static const struct {
+    const char* name;
+    applet_main main;
+} applets[] = {
+    { "i2cread", i2cread_main },
+    { "i2cread_axp", i2cread_axp_main },
+    { "i2cread_axp_full", i2cread_axp_full_main },
+    { "i2cset_axp", i2cset_axp_main },
+    { "axplog_decode", axplog_decode_main },
+    { "i2cbench_axp", i2cbench_axp_main },
+    { "axpd", axpd_main },
+    { "axpmetrics", axpmetrics_main },
+    { "axpsnap", axpsnap_main },
+    { "axppoll", axppoll_main },
+};
+
+#define APPLET_COUNT (sizeof(applets) / sizeof(applets[0]))
+
+static applet_main find_applet(const char* path) {
+    const char* name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+    for (size_t i = 0; i < APPLET_COUNT; ++i)
+        if (strcmp(applets[i].name, name) == 0)
+            return applets[i].main;
+    return NULL;
+}
+
+// Symlink every tool name in `dir` to this binary
+static int install_links(const char* self, const char* dir) {
+    char target[4096], link[4096];
+    ssize_t n = readlink("/proc/self/exe", target, sizeof(target) - 1);
+    if (n < 0) {
+        snprintf(target, sizeof(target), "%s", self);
+        n = strlen(target);
+    }
+    target[n] = '\0';
+
+    int ret = 0;
+    for (size_t i = 0; i < APPLET_COUNT; ++i) {
+        snprintf(link, sizeof(link), "%s/%s", dir, applets[i].name);
+        if (symlink(target, link) < 0) {
+            perror(link);
+            ret = 1;
+        }
+    }
+    return ret;
+}
+
+static int usage(const char* self) {
+    fprintf(stderr, "Usage: %s <tool> [args...]\n       %s --install <dir>\n\nTools:", self, self);
+    for (size_t i = 0; i < APPLET_COUNT; ++i)
+        fprintf(stderr, " %s", applets[i].name);
+    fprintf(stderr, "\n");
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    applet_main fn = find_applet(argv[0]);
+    if (fn)
+        return fn(argc, argv);
+
+    if (argc == 3 && strcmp(argv[1], "--install") == 0)
+        return install_links(argv[0], argv[2]);
+    if (argc < 2 || !(fn = find_applet(argv[1])))
+        return usage(argv[0]);
+    return fn(argc - 1, argv + 1);
+}
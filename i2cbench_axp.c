@@ -0,0 +1,302 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "axp223_i2c.h"
+#include "axp223_decode.h"
+#include "axp223_regs.h"
+
+// ==========================
+// Micro-Benchmarks
+// ==========================
+// Measures the register access paths and decoders against a real bus or
+// the simulator ("sim[:opts]"). Every benchmark records the latency of each
+// iteration with CLOCK_MONOTONIC_RAW and reports p50/p99/p999, the
+// transaction and byte rate on the bus, and a log2 latency histogram.
+// --format=json|csv gives one machine-readable line per benchmark for
+// regression tracking between releases.
+
+#define MAX_ITERATIONS 1000000
+#define HIST_BUCKETS 32
+
+typedef struct {
+    const char* name;
+    const char* unit;       // was eine Iteration ist
+    size_t per_iter;        // Register/Elemente pro Iteration (fuer ns/Element)
+    int (*run)(axp_i2c_dev* dev);
+    bool needs_dev_fd;      // nur gegen echten Bus
+} bench;
+
+typedef struct {
+    uint64_t xfers;
+    uint64_t bytes;
+    int (*inner)(axp_i2c_dev* dev, struct i2c_msg* msgs, unsigned nmsgs);
+} bus_counter;
+
+static bus_counter counter;
+static uint64_t samples[MAX_ITERATIONS];
+
+// Zaehlt Transaktionen und Nutzbytes unterhalb der Transaktionsschicht
+static int counting_xfer(axp_i2c_dev* dev, struct i2c_msg* msgs, unsigned nmsgs) {
+    counter.xfers++;
+    for (unsigned i = 0; i < nmsgs; ++i)
+        counter.bytes += msgs[i].len;
+    return counter.inner(dev, msgs, nmsgs);
+}
+
+static uint64_t raw_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// ==========================
+// Varianten
+// ==========================
+
+static uint8_t table_addrs[MAX_REGISTERS];
+static axp_i2c_span plan_gap0[AXP_I2C_MAX_SPANS], plan_gap4[AXP_I2C_MAX_SPANS];
+static size_t plan_gap0_n, plan_gap4_n;
+static axp_snapshot bench_snap;
+static char out_buf[32768];
+static FILE* devnull;
+
+static int run_read_single(axp_i2c_dev* dev) {
+    uint8_t v;
+    return axp_i2c_read_block(dev, 0x33, &v, 1);
+}
+
+// Alter Pfad: I2C_SLAVE + write() + read(), zwei Syscalls pro Register
+static int run_read_legacy(axp_i2c_dev* dev) {
+    uint8_t reg = 0x33, v;
+    if (write(dev->fd, &reg, 1) != 1 || read(dev->fd, &v, 1) != 1)
+        return -1;
+    counter.xfers += 2;
+    counter.bytes += 2;
+    return 0;
+}
+
+static int run_dump_per_register(axp_i2c_dev* dev) {
+    uint8_t v;
+    for (size_t i = 0; i < REGISTER_COUNT; ++i)
+        if (axp_i2c_read_block(dev, table_addrs[i], &v, 1) < 0)
+            return -1;
+    return 0;
+}
+
+static int run_dump_batched(axp_i2c_dev* dev) {
+    uint8_t values[MAX_REGISTERS];
+    return axp_i2c_read_regs(dev, table_addrs, values, REGISTER_COUNT);
+}
+
+static int run_dump_planned_gap0(axp_i2c_dev* dev) {
+    axp_snapshot snap;
+    return axp_snapshot_read(dev, &snap, plan_gap0, plan_gap0_n);
+}
+
+static int run_dump_planned_gap4(axp_i2c_dev* dev) {
+    axp_snapshot snap;
+    return axp_snapshot_read(dev, &snap, plan_gap4, plan_gap4_n);
+}
+
+static int run_decode_text(axp_i2c_dev* dev) {
+    (void)dev;
+    axp_out out = { out_buf, 0, sizeof(out_buf) };
+    axp_render_range(&out, &bench_snap, 0x00, 0xFF);
+    return out.len ? 0 : -1;
+}
+
+static int run_decode_json(axp_i2c_dev* dev) {
+    (void)dev;
+    axp_out out = { out_buf, 0, sizeof(out_buf) };
+    axp_rec rec;
+    axp_rec_begin(&rec, &out, AXP_FMT_JSON, false);
+    axp_rec_decoded(&rec, &bench_snap, 0x00, 0xFF);
+    axp_rec_end(&rec);
+    return out.len ? 0 : -1;
+}
+
+// Tabelle wie print_table() in i2cread_axp_full, per stdio nach /dev/null
+static int run_print_table(axp_i2c_dev* dev) {
+    (void)dev;
+    fprintf(devnull, "| Addr | Section     | Name                  | Value (Hex) |\n");
+    for (size_t i = 0; i < REGISTER_COUNT; ++i)
+        fprintf(devnull, "| 0x%02X | %-11s | %-22s |     0x%02X     |\n",
+                registers[i].address, registers[i].section, registers[i].name,
+                bench_snap.reg[registers[i].address]);
+    return fflush(devnull);
+}
+
+static const bench benches[] = {
+    { "read_reg.rdwr",         "register", 1,              run_read_single,       false },
+    { "read_reg.legacy",       "register", 1,              run_read_legacy,       true  },
+    { "dump.per_register",     "dump",     REGISTER_COUNT, run_dump_per_register, false },
+    { "dump.batched",          "dump",     REGISTER_COUNT, run_dump_batched,      false },
+    { "dump.planned_gap0",     "dump",     REGISTER_COUNT, run_dump_planned_gap0, false },
+    { "dump.planned_gap4",     "dump",     REGISTER_COUNT, run_dump_planned_gap4, false },
+    { "decode.text",           "snapshot", AXP_DECODE_COUNT, run_decode_text,     false },
+    { "decode.json",           "snapshot", AXP_DECODE_COUNT, run_decode_json,     false },
+    { "print_table.stdio",     "table",    REGISTER_COUNT, run_print_table,       false },
+};
+
+// ==========================
+// Auswertung
+// ==========================
+
+static int cmp_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+static uint64_t percentile(const uint64_t* sorted, size_t n, unsigned per_mille_x10) {
+    size_t idx = (size_t)((uint64_t)(n - 1) * per_mille_x10 / 10000);
+    return sorted[idx];
+}
+
+static void report(const bench* b, int format, size_t n, uint64_t total_ns, unsigned errors) {
+    qsort(samples, n, sizeof(samples[0]), cmp_u64);
+    uint64_t p50 = percentile(samples, n, 5000);
+    uint64_t p99 = percentile(samples, n, 9900);
+    uint64_t p999 = percentile(samples, n, 9990);
+    uint64_t max = samples[n - 1];
+    uint64_t mean = total_ns / n;
+    double secs = total_ns / 1e9;
+    double xfers_s = counter.xfers / secs;
+    double bytes_s = counter.bytes / secs;
+    uint64_t per_elem = mean / b->per_iter;
+
+    unsigned hist[HIST_BUCKETS] = {0};
+    for (size_t i = 0; i < n; ++i) {
+        unsigned bucket = 0;
+        for (uint64_t v = samples[i]; v > 1 && bucket < HIST_BUCKETS - 1; v >>= 1)
+            bucket++;
+        hist[bucket]++;
+    }
+
+    if (format == AXP_FMT_JSON) {
+        printf("{\"bench\":\"%s\",\"unit\":\"%s\",\"iterations\":%zu,\"errors\":%u,"
+               "\"mean_ns\":%llu,\"p50_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu,\"max_ns\":%llu,"
+               "\"ns_per_element\":%llu,\"xfers_per_iter\":%.2f,\"xfers_per_s\":%.0f,\"bytes_per_s\":%.0f,"
+               "\"hist_log2_ns\":[",
+               b->name, b->unit, n, errors,
+               (unsigned long long)mean, (unsigned long long)p50, (unsigned long long)p99,
+               (unsigned long long)p999, (unsigned long long)max, (unsigned long long)per_elem,
+               (double)counter.xfers / n, xfers_s, bytes_s);
+        for (int i = 0; i < HIST_BUCKETS; ++i)
+            printf("%s%u", i ? "," : "", hist[i]);
+        printf("]}\n");
+    } else if (format == AXP_FMT_CSV) {
+        printf("%s,%s,%zu,%u,%llu,%llu,%llu,%llu,%llu,%llu,%.2f,%.0f,%.0f\n",
+               b->name, b->unit, n, errors,
+               (unsigned long long)mean, (unsigned long long)p50, (unsigned long long)p99,
+               (unsigned long long)p999, (unsigned long long)max, (unsigned long long)per_elem,
+               (double)counter.xfers / n, xfers_s, bytes_s);
+    } else {
+        printf("%-20s %8zu  p50 %9llu  p99 %9llu  p999 %9llu ns/%s  %7llu ns/elem  %6.1f xfer/it  %9.0f xfer/s  %10.0f B/s%s\n",
+               b->name, n, (unsigned long long)p50, (unsigned long long)p99,
+               (unsigned long long)p999, b->unit, (unsigned long long)per_elem,
+               (double)counter.xfers / n, xfers_s, bytes_s, errors ? "  (errors!)" : "");
+    }
+}
+
+static void run_bench(const bench* b, axp_i2c_dev* dev, size_t iterations, int format) {
+    // Aufwaermen (Caches, Seiten, Treiber)
+    for (size_t i = 0; i < iterations / 100 + 1; ++i)
+        b->run(dev);
+
+    counter.xfers = counter.bytes = 0;
+    unsigned errors = 0;
+    uint64_t total = 0;
+    for (size_t i = 0; i < iterations; ++i) {
+        uint64_t t0 = raw_ns();
+        if (b->run(dev) < 0)
+            errors++;
+        uint64_t dt = raw_ns() - t0;
+        samples[i] = dt;
+        total += dt;
+    }
+    report(b, format, iterations, total ? total : 1, errors);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <i2c-bus|sim[:opts]> <device-hex> [--iterations=N] "
+                        "[--format=text|json|csv] [--only=<prefix>]\n", argv[0]);
+        return 1;
+    }
+
+    const char* bus = argv[1];
+    int addr = (int)strtol(argv[2], NULL, 16);
+    size_t iterations = 10000;
+    int format = AXP_FMT_TEXT;
+    const char* only = NULL;
+
+    for (int i = 3; i < argc; ++i) {
+        if (strncmp(argv[i], "--iterations=", 13) == 0) {
+            iterations = strtoul(argv[i] + 13, NULL, 10);
+        } else if (strncmp(argv[i], "--format=", 9) == 0) {
+            format = axp_parse_format(argv[i] + 9);
+            if (format < 0 || format == AXP_FMT_KV) {
+                fprintf(stderr, "Unsupported format: %s\n", argv[i] + 9);
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--only=", 7) == 0) {
+            only = argv[i] + 7;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (iterations == 0 || iterations > MAX_ITERATIONS) {
+        fprintf(stderr, "--iterations must be 1..%d\n", MAX_ITERATIONS);
+        return 1;
+    }
+
+    axp_i2c_dev dev;
+    if (axp_i2c_open(&dev, bus, addr) < 0) {
+        perror("Open I2C bus failed");
+        return 1;
+    }
+    fprintf(stderr, "Access path: %s (I2C_FUNCS 0x%08lx)\n", axp_i2c_access_name(&dev), dev.funcs);
+    counter.inner = dev.xfer;
+    dev.xfer = counting_xfer;
+
+    devnull = fopen("/dev/null", "w");
+    if (!devnull) {
+        perror("Open /dev/null failed");
+        return 1;
+    }
+
+    for (size_t i = 0; i < REGISTER_COUNT; ++i)
+        table_addrs[i] = registers[i].address;
+    plan_gap0_n = axp_i2c_plan_reads(table_addrs, REGISTER_COUNT, 0, plan_gap0, AXP_I2C_MAX_SPANS);
+    plan_gap4_n = axp_i2c_plan_reads(table_addrs, REGISTER_COUNT, 4, plan_gap4, AXP_I2C_MAX_SPANS);
+
+    // Decoder laufen auf einem echten Snapshot
+    if (axp_snapshot_read(&dev, &bench_snap, plan_gap4, plan_gap4_n) < 0) {
+        perror("Initial snapshot failed");
+        return 1;
+    }
+
+    // Legacy-Pfad braucht I2C_SLAVE auf einem echten Adapter
+    bool legacy_ok = dev.fd >= 0 && ioctl(dev.fd, I2C_SLAVE, addr) >= 0;
+
+    if (format == AXP_FMT_CSV)
+        printf("bench,unit,iterations,errors,mean_ns,p50_ns,p99_ns,p999_ns,max_ns,"
+               "ns_per_element,xfers_per_iter,xfers_per_s,bytes_per_s\n");
+
+    for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); ++i) {
+        const bench* b = &benches[i];
+        if (only && strncmp(b->name, only, strlen(only)) != 0)
+            continue;
+        if (b->needs_dev_fd && !legacy_ok)
+            continue;
+        run_bench(b, &dev, iterations, format);
+    }
+
+    fclose(devnull);
+    axp_i2c_close(&dev);
+    return 0;
+}
@@ -1,8 +1,6 @@
 #include <stdio.h>
-#include <fcntl.h>
-#include <unistd.h>
-#include <sys/ioctl.h>
-#include <linux/i2c-dev.h>
+#include <stdlib.h>
+#include "axp223_i2c.h"
 
 int main(int argc, char **argv) {
     if (argc != 4) {
@@ -14,28 +12,20 @@ int main(int argc, char **argv) {
     int addr = (int)strtol(argv[2], NULL, 16);
     int reg = (int)strtol(argv[3], NULL, 16);
 
-    int file = open(dev_path, O_RDWR);
-    if (file < 0) {
+    axp_i2c_dev dev;
+    if (axp_i2c_open(&dev, dev_path, addr) < 0) {
         perror("open");
         return 1;
     }
 
-    if (ioctl(file, I2C_SLAVE, addr) < 0) {
-        perror("ioctl");
-        return 1;
-    }
-
-    unsigned char buf[1] = { reg };
-    if (write(file, buf, 1) != 1) {
-        perror("write");
-        return 1;
-    }
-
-    if (read(file, buf, 1) != 1) {
+    unsigned char buf[1];
+    if (axp_i2c_read_block(&dev, reg, buf, 1) < 0) {
         perror("read");
+        axp_i2c_close(&dev);
         return 1;
     }
 
     printf("Value at 0x%02x: 0x%02x\n", reg, buf[0]);
+    axp_i2c_close(&dev);
     return 0;
 }
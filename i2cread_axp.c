@@ -1,71 +1,488 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <fcntl.h>
-#include <linux/i2c-dev.h>
-#include <sys/ioctl.h>
-#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/timerfd.h>
+#include "axp223_i2c.h"
+#include "axp223_ring.h"
+#include "axp223_log.h"
+#include "axp223_energy.h"
+#include "axp223_capture.h"
+#include "axp223_decode.h"
+#include "axp223_adcsync.h"
 
-int read_reg(int fd, int addr) {
-    if (write(fd, &addr, 1) != 1) {
-        perror("Failed to write register address");
-        return -1;
+// Festkomma in 0.1-Einheiten statt float (kein Soft-Float-printf auf ARMv7)
+#define VOLTAGE_DMV(raw) ((raw) * 11)   // 1.1 mV/LSB
+#define CURRENT_DMA(raw) ((raw) * 5)    // 0.5 mA/LSB
+
+void print_voltage(int reg_high, int reg_low) {
+    int raw = (reg_high << 4) | (reg_low & 0x0F);
+    int dmv = VOLTAGE_DMV(raw);
+    printf("Battery Voltage: %d.%d mV\n", dmv / 10, dmv % 10);
+}
+
+void print_current(const char* label, int reg_high, int reg_low) {
+    int raw = (reg_high << 5) | (reg_low & 0x1F);
+    int dma = CURRENT_DMA(raw);
+    printf("%s: %d.%d mA\n", label, dma / 10, dma % 10);
+}
+
+// ==========================
+// Daemon-Modus
+// ==========================
+// The sampling loop keeps the bus open, waits on an absolute timerfd
+// deadline (next = start + n * period, so there is no drift) and pushes raw
+// samples into the ring. A consumer thread drains the ring in batches and
+// does all formatting, so printf never delays a bus read. With --log the
+// consumer appends raw binary records instead of formatting text. With
+// --energy it integrates every sample into the persisted charge/energy
+// accumulators (axp223_energy.h); without --log it then prints nothing.
+// With --capture the sampler also reads IRQ status REG48–REG4C and the
+// consumer keeps a pre-trigger window; only the samples around a trigger
+// are written (axp223_capture.h).
+// With --adc-sync reads follow the PMIC's own ADC conversions instead of a
+// free-running timer (axp223_adcsync.h): one read per conversion (or per
+// n-th one for a lower --rate), between two conversion edges. A read that
+// lands on a conversion already handed out is dropped before the ring.
+
+static axp_ring ring;
+static axp_log_writer log_writer = { .fd = -1 };
+static axp_energy energy = { .fd = -1 };
+static axp_capture capture = { .fd = -1 };
+static volatile sig_atomic_t stop_requested;
+static _Atomic int producer_done;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void emit_sample(const axp_sample* s) {
+    if (!s->ok) {
+        printf("%llu.%06llu read-error\n",
+               (unsigned long long)(s->t_ns / 1000000000ull),
+               (unsigned long long)(s->t_ns % 1000000000ull) / 1000);
+        return;
     }
+    int dmv = VOLTAGE_DMV((s->adc[0] << 4) | (s->adc[1] & 0x0F));
+    int chg = CURRENT_DMA((s->adc[2] << 5) | (s->adc[3] & 0x1F));
+    int dis = CURRENT_DMA((s->adc[4] << 5) | (s->adc[5] & 0x1F));
+    printf("%llu.%06llu %d.%d mV %d.%d mA %d.%d mA%s\n",
+           (unsigned long long)(s->t_ns / 1000000000ull),
+           (unsigned long long)(s->t_ns % 1000000000ull) / 1000,
+           dmv / 10, dmv % 10, chg / 10, chg % 10, dis / 10, dis % 10,
+           s->missed ? " (late)" : "");
+}
 
-    unsigned char buf;
-    if (read(fd, &buf, 1) != 1) {
-        perror("Failed to read register");
-        return -1;
+static void sample_record(const axp_sample* s, axp_log_record* rec) {
+    rec->t_ns = s->t_ns;
+    rec->raw[AXP_LOG_RAW_TEMP_H] = s->temp[0];
+    rec->raw[AXP_LOG_RAW_TEMP_L] = s->temp[1];
+    memcpy(&rec->raw[AXP_LOG_RAW_VBAT_H], s->adc, sizeof(s->adc));
+}
+
+static void log_sample(const axp_sample* s) {
+    if (!s->ok) {
+        log_writer.hdr->read_errors++;
+        return;
+    }
+    axp_log_record rec;
+    sample_record(s, &rec);
+    if (axp_log_append(&log_writer, &rec) < 0) {
+        perror("Log append failed");
+        stop_requested = 1;
     }
+}
 
-    return buf;
+static void capture_sample(const axp_sample* s) {
+    axp_log_record rec;
+    if (s->ok)
+        sample_record(s, &rec);
+    uint64_t events = capture.events;
+    if (axp_capture_add(&capture, s->ok ? &rec : NULL, s->irq) < 0) {
+        perror("Write capture event failed");
+        stop_requested = 1;
+    } else if (capture.events != events) {
+        fprintf(stderr, "capture: event %llu written\n", (unsigned long long)capture.events);
+    }
 }
 
-void print_voltage(int reg_high, int reg_low) {
-    int raw = (reg_high << 4) | (reg_low & 0x0F);
-    float voltage = raw * 1.1;
-    printf("Battery Voltage: %.1f mV\n", voltage);
+static void integrate_sample(const axp_sample* s) {
+    if (!s->ok) {
+        axp_energy_add(&energy, NULL);
+        return;
+    }
+    axp_energy_sample es = {
+        .t_ns = s->t_ns,
+        .dmv = VOLTAGE_DMV((s->adc[0] << 4) | (s->adc[1] & 0x0F)),
+        .chg_dma = CURRENT_DMA((s->adc[2] << 5) | (s->adc[3] & 0x1F)),
+        .dis_dma = CURRENT_DMA((s->adc[4] << 5) | (s->adc[5] & 0x1F)),
+    };
+    axp_energy_add(&energy, &es);
 }
 
-void print_current(const char* label, int reg_high, int reg_low) {
-    int raw = (reg_high << 5) | (reg_low & 0x1F);
-    float current = raw * 0.5;
-    printf("%s: %.1f mA\n", label, current);
+static void* consumer_main(void* arg) {
+    (void)arg;
+    const struct timespec idle = { 0, 10 * 1000 * 1000 };
+    bool binary = log_writer.fd >= 0;
+    bool text = !binary && energy.fd < 0 && capture.fd < 0;
+    axp_sample s;
+
+    for (;;) {
+        // Flag vor dem Leeren lesen, damit kein letztes Sample verloren geht
+        int done = atomic_load(&producer_done);
+        bool got = false;
+        while (axp_ring_pop(&ring, &s)) {
+            if (energy.fd >= 0)
+                integrate_sample(&s);
+            if (capture.fd >= 0)
+                capture_sample(&s);
+            if (binary)
+                log_sample(&s);
+            else if (text)
+                emit_sample(&s);
+            got = true;
+        }
+        if (got && text)
+            fflush(stdout);
+        if (done)
+            break;
+        if (!got)
+            nanosleep(&idle, NULL);
+    }
+    return NULL;
+}
+
+typedef struct {
+    const char* path;
+    unsigned pre, post;
+    uint8_t trigger[AXP_CAPTURE_IRQ_COUNT];
+} capture_opts;
+
+typedef struct {
+    bool on;
+    unsigned set_hz;        // REG84 vorher umstellen, 0 = wie konfiguriert
+    unsigned adc_hz;        // ADC-Takt laut REG84
+    unsigned every;         // jede n-te Wandlung lesen
+} sync_opts;
+
+// Read REG84, program the rate if asked to; returns the ADC rate in Hz or 0
+static unsigned setup_adc_sync(axp_i2c_dev* dev, unsigned set_hz) {
+    uint8_t reg = AXP_ADC_RATE_REG, val;
+    if (axp_i2c_read_regs(dev, &reg, &val, 1) < 0) {
+        perror("Read REG84 failed");
+        return 0;
+    }
+    if (set_hz) {
+        uint8_t want = (val & 0x3F) | axp_adc_rate_bits(set_hz);
+        if (want != val) {
+            if (axp_i2c_write_regs(dev, &reg, &want, 1) < 0 || axp_i2c_read_regs(dev, &reg, &val, 1) < 0) {
+                perror("Set ADC sample rate failed");
+                return 0;
+            }
+            if (val != want) {
+                fprintf(stderr, "REG84 reads back 0x%02X instead of 0x%02X\n", val, want);
+                return 0;
+            }
+        }
+    }
+    fprintf(stderr, "adc-sync: REG84 0x%02X, ADC at %u Hz\n", val, axp_adc_rate_hz(val));
+    return axp_adc_rate_hz(val);
+}
+
+// "vbus_removed,battery_overtemp,pek_long" -> Masken fuer REG48..REG4C
+static int parse_trigger(const char* list, uint8_t* mask) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", list);
+    memset(mask, 0, AXP_CAPTURE_IRQ_COUNT);
+    for (char* save = NULL, *key = strtok_r(buf, ",", &save); key; key = strtok_r(NULL, ",", &save)) {
+        const axp_field* f = NULL;
+        const axp_reg_desc* d = axp_decode_find(key, &f);
+        if (!d) {
+            axp_decode_explain(stderr, "IRQ trigger", key);
+            return -1;
+        }
+        if (d->reg < AXP_CAPTURE_IRQ_FIRST || d->reg >= AXP_CAPTURE_IRQ_FIRST + AXP_CAPTURE_IRQ_COUNT) {
+            fprintf(stderr, "Not an IRQ trigger: %s\n", key);
+            return -1;
+        }
+        mask[d->reg - AXP_CAPTURE_IRQ_FIRST] |= 1u << f->shift;
+    }
+    return 0;
+}
+
+// Ausgeloeste Trigger-Bits loeschen (write-1-to-clear), damit das naechste
+// Ereignis wieder als neues Bit erscheint
+static void clear_triggers(axp_i2c_dev* dev, const uint8_t* trigger, const uint8_t* irq) {
+    uint8_t regs[AXP_CAPTURE_IRQ_COUNT], values[AXP_CAPTURE_IRQ_COUNT];
+    size_t n = 0;
+    for (int i = 0; i < AXP_CAPTURE_IRQ_COUNT; ++i) {
+        if (irq[i] & trigger[i]) {
+            regs[n] = AXP_CAPTURE_IRQ_FIRST + i;
+            values[n++] = irq[i] & trigger[i];
+        }
+    }
+    if (n && axp_i2c_write_regs(dev, regs, values, n) < 0)
+        perror("Clear IRQ status failed");
+}
+
+static int run_daemon(axp_i2c_dev* dev, unsigned rate_hz, unsigned long count, const char* log_path,
+                      const char* energy_path, const capture_opts* cap, const sync_opts* sync) {
+    int tfd = timerfd_create(CLOCK_MONOTONIC, 0);
+    if (tfd < 0) {
+        perror("timerfd_create failed");
+        return 1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;  // ohne SA_RESTART, damit read() abbricht
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    uint64_t period_ns = 1000000000ull / rate_hz;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    struct itimerspec its = {
+        .it_interval = { period_ns / 1000000000ull, period_ns % 1000000000ull },
+        .it_value = start,
+    };
+    if (timerfd_settime(tfd, TFD_TIMER_ABSTIME, &its, NULL) < 0) {
+        perror("timerfd_settime failed");
+        close(tfd);
+        return 1;
+    }
+
+    if (log_path && axp_log_open(&log_writer, log_path, dev->addr, rate_hz,
+                                 (uint64_t)start.tv_sec * 1000000000ull + start.tv_nsec) < 0) {
+        perror("Open log file failed");
+        close(tfd);
+        return 1;
+    }
+
+    if (energy_path && axp_energy_open(&energy, energy_path) < 0) {
+        perror("Open energy state failed");
+        axp_log_close(&log_writer);
+        close(tfd);
+        return 1;
+    }
+
+    if (cap->path && axp_capture_open(&capture, cap->path, dev->addr, rate_hz,
+                                      (uint64_t)start.tv_sec * 1000000000ull + start.tv_nsec,
+                                      cap->pre, cap->post, cap->trigger) < 0) {
+        perror("Open capture file failed");
+        axp_energy_close(&energy);
+        axp_log_close(&log_writer);
+        close(tfd);
+        return 1;
+    }
+
+    // Temperatur (0x56/0x57) und Batterie-ADC (0x78-0x7D) in einem ioctl,
+    // mit --capture zusaetzlich der IRQ-Status (0x48-0x4C)
+    static const axp_i2c_span adc_spans[] = { { 0x48, 5 }, { 0x56, 2 }, { 0x78, 6 } };
+    const axp_i2c_span* spans = cap->path ? adc_spans : adc_spans + 1;
+    size_t nspans = cap->path ? 3 : 2;
+    uint8_t image[256] = { 0 };
+
+    axp_adc_lock lock;
+    if (sync->on)
+        axp_adc_lock_init(&lock, sync->adc_hz, sync->every, (uint64_t)start.tv_sec * 1000000000ull + start.tv_nsec);
+    uint64_t polls = 0;
+
+    pthread_t consumer;
+    if (pthread_create(&consumer, NULL, consumer_main, NULL) != 0) {
+        fprintf(stderr, "Failed to start consumer thread\n");
+        axp_capture_close(&capture);
+        axp_energy_close(&energy);
+        axp_log_close(&log_writer);
+        close(tfd);
+        return 1;
+    }
+
+    unsigned long n = 0;
+    while (!stop_requested && (count == 0 || n < count)) {
+        uint64_t planned = 0;
+        if (sync->on) {
+            // Einmaliger Timer auf den naechsten geplanten Lesezeitpunkt
+            planned = axp_adc_lock_next(&lock);
+            struct itimerspec at = { .it_value = { planned / 1000000000ull, planned % 1000000000ull } };
+            if (timerfd_settime(tfd, TFD_TIMER_ABSTIME, &at, NULL) < 0) {
+                perror("timerfd_settime failed");
+                break;
+            }
+        }
+        uint64_t ticks;
+        if (read(tfd, &ticks, sizeof(ticks)) != sizeof(ticks)) {
+            if (errno == EINTR)
+                continue;
+            perror("timerfd read failed");
+            break;
+        }
+
+        axp_sample s;
+        s.t_ns = now_ns();
+        s.ok = axp_i2c_read_spans(dev, spans, nspans, image) == 0;
+        memcpy(s.temp, &image[0x56], sizeof(s.temp));
+        memcpy(s.adc, &image[0x78], sizeof(s.adc));
+        memcpy(s.irq, &image[AXP_CAPTURE_IRQ_FIRST], sizeof(s.irq));
+        polls++;
+
+        if (sync->on) {
+            uint8_t conv[AXP_ADC_LOCK_BYTES];
+            memcpy(conv, s.adc, sizeof(s.adc));
+            memcpy(conv + sizeof(s.adc), s.temp, sizeof(s.temp));
+            unsigned missed;
+            if (!axp_adc_lock_feed(&lock, s.ok ? conv : NULL, planned, s.t_ns, now_ns(), &missed))
+                continue;
+            ticks = 1 + (uint64_t)missed;
+        }
+
+        if (s.ok && cap->path)
+            clear_triggers(dev, cap->trigger, s.irq);
+        s.missed = ticks > 256 ? 255 : (uint8_t)(ticks - 1);
+        axp_ring_push(&ring, &s);
+        n++;
+    }
+
+    atomic_store(&producer_done, 1);
+    pthread_join(consumer, NULL);
+    if (capture.fd >= 0)
+        fprintf(stderr, "capture: %llu events\n", (unsigned long long)capture.events);
+    axp_capture_close(&capture);
+    axp_energy_close(&energy);
+    axp_log_close(&log_writer);
+    close(tfd);
+
+    axp_i2c_report(dev, "i2cread_axp");
+    if (sync->on) {
+        int64_t ppm = ((int64_t)lock.nominal_ps - (int64_t)lock.period_ps) * 1000000 / (int64_t)lock.period_ps;
+        fprintf(stderr, "adc-sync: %lu samples from %llu reads (%llu probe reads, %llu probes, %llu without change, "
+                        "%llu relocks), %llu duplicates dropped, ADC clock %+lld ppm against REG84\n",
+                n, (unsigned long long)polls, (unsigned long long)lock.probe_reads,
+                (unsigned long long)lock.probes, (unsigned long long)lock.empty_probes,
+                (unsigned long long)lock.relocks,
+                (unsigned long long)lock.duplicates, (long long)ppm);
+    }
+    uint32_t dropped = atomic_load(&ring.dropped);
+    if (dropped)
+        fprintf(stderr, "%u samples dropped (consumer too slow)\n", dropped);
+    return 0;
 }
 
 int main(int argc, char *argv[]) {
-    if (argc != 3) {
-        fprintf(stderr, "Usage: %s <i2c-bus-path> <device-hex>\n", argv[0]);
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <i2c-bus-path> <device-hex> [--rate=HZ|--adc-sync[=HZ] [--count=N] [--log=FILE]\n"
+                        "       [--energy=STATE] [--capture=FILE [--trigger=IRQ,...] [--pre=N] [--post=N]]]\n", argv[0]);
         return 1;
     }
 
     const char *i2c_bus = argv[1];
     int addr = (int)strtol(argv[2], NULL, 16);
+    unsigned rate_hz = 0;
+    unsigned long count = 0;
+    const char* log_path = NULL;
+    const char* energy_path = NULL;
+    const char* trigger = "vbus_removed,battery_overtemp,pek_long";
+    capture_opts cap = { NULL, 100, 100, { 0 } };
+    sync_opts sync = { false, 0, 0, 1 };
 
-    int fd = open(i2c_bus, O_RDWR);
-    if (fd < 0) {
-        perror("Failed to open I2C bus");
+    for (int i = 3; i < argc; ++i) {
+        if (strncmp(argv[i], "--rate=", 7) == 0) {
+            rate_hz = (unsigned)strtoul(argv[i] + 7, NULL, 10);
+        } else if (strcmp(argv[i], "--adc-sync") == 0) {
+            sync.on = true;
+        } else if (strncmp(argv[i], "--adc-sync=", 11) == 0) {
+            sync.on = true;
+            sync.set_hz = (unsigned)strtoul(argv[i] + 11, NULL, 10);
+            if (axp_adc_rate_bits(sync.set_hz) < 0) {
+                fprintf(stderr, "--adc-sync takes 100, 200, 400 or 800 Hz\n");
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--count=", 8) == 0) {
+            count = strtoul(argv[i] + 8, NULL, 10);
+        } else if (strncmp(argv[i], "--log=", 6) == 0) {
+            log_path = argv[i] + 6;
+        } else if (strncmp(argv[i], "--energy=", 9) == 0) {
+            energy_path = argv[i] + 9;
+        } else if (strncmp(argv[i], "--capture=", 10) == 0) {
+            cap.path = argv[i] + 10;
+        } else if (strncmp(argv[i], "--trigger=", 10) == 0) {
+            trigger = argv[i] + 10;
+        } else if (strncmp(argv[i], "--pre=", 6) == 0) {
+            cap.pre = (unsigned)strtoul(argv[i] + 6, NULL, 10);
+        } else if (strncmp(argv[i], "--post=", 7) == 0) {
+            cap.post = (unsigned)strtoul(argv[i] + 7, NULL, 10);
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    // Ohne Takt gibt es nur die Einzelmessung, die Optionen wuerden still verfallen
+    if ((log_path || count) && rate_hz == 0 && !sync.on) {
+        fprintf(stderr, "--log and --count need --rate or --adc-sync\n");
+        return 1;
+    }
+    if (energy_path && rate_hz == 0 && !sync.on) {
+        fprintf(stderr, "--energy needs --rate or --adc-sync\n");
         return 1;
     }
+    if (cap.path && ((rate_hz == 0 && !sync.on) || cap.pre > AXP_CAPTURE_MAX || cap.post > AXP_CAPTURE_MAX)) {
+        fprintf(stderr, "--capture needs --rate or --adc-sync, --pre and --post at most %d\n", AXP_CAPTURE_MAX);
+        return 1;
+    }
+    if (parse_trigger(trigger, cap.trigger) < 0)
+        return 1;
 
-    if (ioctl(fd, I2C_SLAVE, addr) < 0) {
-        perror("Failed to set I2C address");
-        close(fd);
+    axp_i2c_dev dev;
+    if (axp_i2c_open(&dev, i2c_bus, addr) < 0) {
+        perror("Failed to open I2C bus");
         return 1;
     }
 
-    int reg78 = read_reg(fd, 0x78);
-    int reg79 = read_reg(fd, 0x79);
-    int reg7a = read_reg(fd, 0x7a);
-    int reg7b = read_reg(fd, 0x7b);
-    int reg7c = read_reg(fd, 0x7c);
-    int reg7d = read_reg(fd, 0x7d);
+    if (sync.on) {
+        sync.adc_hz = setup_adc_sync(&dev, sync.set_hz);
+        if (!sync.adc_hz) {
+            axp_i2c_close(&dev);
+            return 1;
+        }
+        // Schneller als der ADC bringt nichts Neues; langsamer: jede n-te Wandlung
+        sync.every = rate_hz && rate_hz < sync.adc_hz ? (sync.adc_hz + rate_hz - 1) / rate_hz : 1;
+        rate_hz = sync.adc_hz / sync.every;
+        if (sync.every > 1)
+            fprintf(stderr, "adc-sync: every %u. conversion, %u Hz\n", sync.every, rate_hz);
+    }
+
+    if (rate_hz > 0) {
+        int ret = run_daemon(&dev, rate_hz, count, log_path, energy_path, &cap, &sync);
+        axp_i2c_close(&dev);
+        return ret;
+    }
+
+    // 0x78-0x7D in one I2C_RDWR transaction
+    static const uint8_t adc_regs[] = { 0x78, 0x79, 0x7a, 0x7b, 0x7c, 0x7d };
+    uint8_t adc[sizeof(adc_regs)];
+    if (axp_i2c_read_regs(&dev, adc_regs, adc, sizeof(adc_regs)) < 0) {
+        perror("Failed to read ADC registers");
+        axp_i2c_close(&dev);
+        return 1;
+    }
 
     printf("=== AXP223 Battery Monitor ===\n");
-    print_voltage(reg78, reg79);
-    print_current("Charge Current", reg7a, reg7b);
-    print_current("Discharge Current", reg7c, reg7d);
+    print_voltage(adc[0], adc[1]);
+    print_current("Charge Current", adc[2], adc[3]);
+    print_current("Discharge Current", adc[4], adc[5]);
 
-    close(fd);
+    axp_i2c_close(&dev);
     return 0;
 }
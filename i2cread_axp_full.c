@@ -1,140 +1,37 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <fcntl.h>
-#include <linux/i2c-dev.h>
-#include <sys/ioctl.h>
-#include <unistd.h>
 #include <string.h>
+#include <strings.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <signal.h>
+#include <linux/gpio.h>
+#include "axp223_i2c.h"
+#include "axp223_decode.h"
+#include "axp223_regs.h"
+#include "axp223_sched.h"
 
 
 
-#define MAX_REGISTERS 128
-
-typedef struct {
-    uint8_t address;
-    const char* name;
-    const char* section;
-    uint8_t value;
-} AXP223_Register;
-
-int read_reg(int fd, uint8_t addr) {
-    if (write(fd, &addr, 1) != 1) {
-        perror("Write register address failed");
-        return -1;
-    }
-    unsigned char buf;
-    if (read(fd, &buf, 1) != 1) {
-        perror("Read register failed");
-        return -1;
-    }
-    return buf;
-}
-
-// ==========================
-// Alle relevanten Register
-// ==========================
-AXP223_Register registers[] = {
-    // Power Control (10.1.1)
-    {0x00, "Power Status", "Power Control"},
-    {0x01, "Charge State", "Power Control"},
-    {0x10, "Power Enable 1", "Power Control"},
-    {0x12, "Power Enable 2", "Power Control"},
-    {0x13, "ALDO3 Enable", "Power Control"},
-    {0x15, "DLDO1 Voltage", "Power Control"},
-    {0x16, "DLDO2 Voltage", "Power Control"},
-    {0x17, "DLDO3 Voltage", "Power Control"},
-    {0x18, "DLDO4 Voltage", "Power Control"},
-    {0x19, "ELDO1 Voltage", "Power Control"},
-    {0x1A, "ELDO2 Voltage", "Power Control"},
-    {0x1B, "ELDO3 Voltage", "Power Control"},
-    {0x1C, "DC5LDO Voltage", "Power Control"},
-    {0x21, "DCDC1 Voltage", "Power Control"},
-    {0x22, "DCDC2 Voltage", "Power Control"},
-    {0x23, "DCDC3 Voltage", "Power Control"},
-    {0x24, "DCDC4 Voltage", "Power Control"},
-    {0x25, "DCDC5 Voltage", "Power Control"},
-    {0x27, "DCDC2/3 Ramp", "Power Control"},
-    {0x28, "ALDO1 Voltage", "Power Control"},
-    {0x29, "ALDO2 Voltage", "Power Control"},
-    {0x2A, "ALDO3 Voltage", "Power Control"},
-    {0x30, "VBUS Path Ctrl", "Power Control"},
-    {0x31, "Wakeup + VOFF", "Power Control"},
-    {0x32, "Shutdown + LED", "Power Control"},
-    {0x33, "Charge Ctrl 1", "Power Control"},
-    {0x34, "Charge Ctrl 2", "Power Control"},
-    {0x35, "Charge Ctrl 3", "Power Control"},
-    {0x36, "PEK Parameters", "Power Control"},
-    {0x37, "DCDC Frequency", "Power Control"},
-    {0x38, "Temp Warn Low", "Power Control"},
-    {0x39, "Temp Warn High", "Power Control"},
-    {0x3C, "Temp Warn Disch Low", "Power Control"},
-    {0x3D, "Temp Warn Disch High", "Power Control"},
-
-    // GPIO Control (10.1.2)
-    {0x90, "GPIO0 Ctrl", "GPIO"},
-    {0x91, "GPIO0 Voltage", "GPIO"},
-    {0x92, "GPIO1 Ctrl", "GPIO"},
-    {0x93, "GPIO1 Voltage", "GPIO"},
-    {0x94, "GPIO Status", "GPIO"},
-    {0x97, "GPIO Pull-Down", "GPIO"},
-
-    // Interrupt Control (10.1.3)
-    {0x40, "IRQ Enable 1", "Interrupt"},
-    {0x41, "IRQ Enable 2", "Interrupt"},
-    {0x42, "IRQ Enable 3", "Interrupt"},
-    {0x43, "IRQ Enable 4", "Interrupt"},
-    {0x44, "IRQ Enable 5", "Interrupt"},
-    {0x48, "IRQ Status 1", "Interrupt"},
-    {0x49, "IRQ Status 2", "Interrupt"},
-    {0x4A, "IRQ Status 3", "Interrupt"},
-    {0x4B, "IRQ Status 4", "Interrupt"},
-    {0x4C, "IRQ Status 5", "Interrupt"},
-
-    // ADC Data (10.1.4)
-    {0x56, "Temp ADC High", "ADC"},
-    {0x57, "Temp ADC Low", "ADC"},
-    {0x58, "TS ADC High", "ADC"},
-    {0x59, "TS ADC Low", "ADC"},
-    {0x78, "Battery Volt High", "ADC"},
-    {0x79, "Battery Volt Low", "ADC"},
-    {0x7A, "Charge Curr High", "ADC"},
-    {0x7B, "Charge Curr Low", "ADC"},
-    {0x7C, "Discharge Curr High", "ADC"},
-    {0x7D, "Discharge Curr Low", "ADC"},
-	
-	    // Weitere Steuer-/Fuel-Gauge/ADC-Register
-    {0x80, "DCDC Mode", "ADC"},
-    {0x82, "ADC Enable", "ADC"},
-    {0x84, "ADC Sample + TS", "ADC"},
-    {0x85, "TS Sample Rate", "ADC"},
-    {0x8A, "Timer Control", "Timer"},
-    {0x8C, "PWREN Control 1", "Power Control"},
-    {0x8D, "PWREN Control 2", "Power Control"},
-    {0x8F, "Overtemp Shutdown", "Power Control"},
-    {0xB8, "Fuel Gauge Ctrl", "Fuel Gauge"},
-    {0xB9, "Fuel Gauge Result", "Fuel Gauge"},
-    {0xE0, "Battery Cap Hi", "Fuel Gauge"},
-    {0xE1, "Battery Cap Lo", "Fuel Gauge"},
-    {0xE6, "Battery Alarm", "Fuel Gauge"},
-    {0xE8, "FG Update Interval", "Fuel Gauge"},
-    {0xE9, "FG Calibration Interval", "Fuel Gauge"},
-    {0xEC, "FG Capacity % Calib", "Fuel Gauge"}
-
-};
-
 // ==========================
 // Tabellen-Ausgabe
 // ==========================
-void print_table(AXP223_Register* regs, size_t count) {
+// Registers without a valid read in `snap` show "--" instead of a value
+void print_table(const AXP223_Register* regs, size_t count, const axp_snapshot* snap) {
     printf("\n=== AXP223 Register Dump ===\n");
     printf("| Addr | Section     | Name                  | Value (Hex) |\n");
     printf("|------|-------------|------------------------|-------------|\n");
 
     for (size_t i = 0; i < count; ++i) {
-        printf("| 0x%02X | %-11s | %-22s |     0x%02X     |\n",
-               regs[i].address, regs[i].section, regs[i].name, regs[i].value);
+        if (!axp_snapshot_is_valid(snap, regs[i].address))
+            printf("| 0x%02X | %-11s | %-22s |      --      |\n",
+                   regs[i].address, regs[i].section, regs[i].name);
+        else
+            printf("| 0x%02X | %-11s | %-22s |     0x%02X     |\n",
+                   regs[i].address, regs[i].section, regs[i].name, regs[i].value);
     }
     printf("\n");
 }
@@ -142,331 +39,706 @@ void print_table(AXP223_Register* regs, size_t count) {
 // ==========================
 // Interpretations
 // ==========================
+// Decoding is table driven (axp223_decode.h); the output is rendered into
+// one buffer and written with a single write().
 
-void interpret_reg00(uint8_t value) {
-    printf("REG00 (Power Input Status): 0x%02X\n", value);
-    printf("  - ACIN Present         : %s\n", (value & 0x80) ? "Yes" : "No");
-    printf("  - ACIN Usable          : %s\n", (value & 0x40) ? "Yes" : "No");
-    printf("  - VBUS Present         : %s\n", (value & 0x20) ? "Yes" : "No");
-    printf("  - VBUS Usable          : %s\n", (value & 0x10) ? "Yes" : "No");
-    printf("  - VBUS > VHOLD         : %s\n", (value & 0x08) ? "Yes" : "No");
-    printf("  - Battery direction        : %s\n", (value & 0x04) ? "charging" : "discharging");
-    printf("  - ACIN/VBUS Short      : %s\n", (value & 0x02) ? "Yes" : "No");
-    printf("  - Power-on via ExtPwr  : %s\n", (value & 0x01) ? "Yes" : "No");
+static char decode_buf[16384];
+
+void interpret_all_irq_status(const axp_snapshot* snap) {
+    if (!axp_snapshot_has(snap, 0x48, 5)) {
+        printf("IRQ status registers 0x48-0x4C not available\n");
+        return;
+    }
+    axp_out out = { decode_buf, 0, sizeof(decode_buf) };
+    axp_out_str(&out, "=== AXP223 IRQ Status Overview ===\n");
+    axp_render_range(&out, snap, 0x48, 0x4C);
+    fflush(stdout);
+    axp_out_flush(&out, STDOUT_FILENO);
 }
 
-void interpret_reg01(uint8_t value) {
-    printf("REG01 (Power Mode / Charge State): 0x%02X\n", value);
-    printf("  - Overtemperature       : %s\n", (value & 0x80) ? "Yes" : "No");
-    printf("  - Charging              : %s\n", (value & 0x40) ? "Yes" : "No");
-    printf("  - Battery Present       : %s\n", (value & 0x20) ? "Yes" : "No");
-    printf("  - Battery Activation    : %s\n", (value & 0x08) ? "Yes" : "No");
+
+// Dekodiert ausschliesslich aus dem Snapshot, kein Buszugriff.
+// Register, die nicht gelesen werden konnten, werden uebersprungen.
+void interpret_registers(const axp_snapshot* snap) {
+    axp_out out = { decode_buf, 0, sizeof(decode_buf) };
+    axp_out_str(&out, "\n=== AXP223 Register Interpretation ===\n");
+    axp_render_range(&out, snap, 0x00, 0xFF);
+    fflush(stdout);
+    axp_out_flush(&out, STDOUT_FILENO);
 }
 
-void interpret_reg32(uint8_t value) {
-    printf("REG32 (Shutdown, Battery Detection, CHGLED Control): 0x%02X\n", value);
-    printf("  - Software Shutdown (bit 7)          : %s\n", (value & 0x80) ? "Active (shutdown requested)" : "Inactive");
-    printf("  - Battery Detection (bit 6)          : %s\n", (value & 0x40) ? "Enabled" : "Disabled");
-    // CHGLED Control Mode (Bit 5–4)
-    uint8_t chg_mode = (value >> 4) & 0x03;
-    const char* chgled_modes[] = {
-        "High-Z (off)",
-        "25%% Duty @ 0.5 Hz (slow blink)",
-        "25%% Duty @ 2 Hz (fast blink)",
-        "Low Level (ON)"
-    };
-    printf("  - CHGLED Mode (bits 5–4)             : %s\n", chgled_modes[chg_mode]);
-    // CHGLED Source Select (Bit 3)
-    printf("  - CHGLED Source (bit 3)              : %s\n", (value & 0x08) ? "Automatic (charger-controlled)" : "Manual (via bits 5–4)");
-    // Shutdown Sequence Timing (Bit 2)
-    printf("  - Power-Off Timing (bit 2)           : %s\n", (value & 0x04) ? "Sequenced off (reverse start order)" : "All at once");
-    // PWROK Delay (Bits 1–0)
-    uint8_t delay = value & 0x03;
-    const char* delays[] = { "8 ms", "16 ms", "32 ms", "64 ms" };
-    printf("  - PWROK Delay (bits 1–0)             : %s after last rail\n", delays[delay]);
+
+// Decoded fields followed by the raw registers[] values as one record
+void print_machine(const axp_snapshot* snap, int format, const uint8_t* addrs, size_t count) {
+    axp_out out = { decode_buf, 0, sizeof(decode_buf) };
+    axp_rec rec;
+
+    if (format == AXP_FMT_CSV) {
+        axp_rec_begin(&rec, &out, format, true);
+        axp_rec_decoded(&rec, snap, 0x00, 0xFF);
+        axp_rec_registers(&rec, snap, addrs, count);
+        axp_rec_end(&rec);
+    }
+    axp_rec_begin(&rec, &out, format, false);
+    axp_rec_decoded(&rec, snap, 0x00, 0xFF);
+    axp_rec_registers(&rec, snap, addrs, count);
+    axp_rec_end(&rec);
+    axp_out_flush(&out, STDOUT_FILENO);
 }
 
-void interpret_reg33(uint8_t value) {
-    printf("REG33 (Charging Control 1): 0x%02X\n", value);
-    // Bit 7: Enable Charging
-    printf("  - Charging Enabled (bit 7)       : %s\n", (value & 0x80) ? "Yes" : "No");
-    // Bits 6–5: Target Voltage (VTRGT)
-    const char* vtrgt_levels[] = {"4.1V", "4.22V", "4.2V", "4.24V"};
-    uint8_t vtrgt = (value >> 5) & 0x03;
-    printf("  - Charge Target Voltage (6:5)   : %s\n", vtrgt_levels[vtrgt]);
-    // Bit 4: Charge Termination Current Threshold
-    printf("  - End-of-Charge Threshold       : %s\n", (value & 0x10) ? "<15%% of CC" : "<10%% of CC");
-    // Bits 3–0: Charge Current
-    uint8_t cc_bits = value & 0x0F;
-    int cc_values[] = {
-        300, 450, 600, 750,
-        900, 1050, 1200, 1350,
-        1500, 1650, 1800, 1950,
-        2100, -1, -1, -1 // ungültige Werte
-    };
-    int current = cc_values[cc_bits];
-    if (current > 0)
-        printf("  - Charge Current (3:0)          : %d mA\n", current);
-    else
-        printf("  - Charge Current (3:0)          : Invalid setting (reserved)\n");
+
+// ==========================
+// IRQ-Event-Modus
+// ==========================
+// Waits on the PMIC's IRQ (NMI) line through the GPIO character device
+// instead of polling 0x48-0x4C. On every falling edge the five status
+// registers are read in one block read, decoded and cleared by writing the
+// set bits back (write-1-to-clear). The line is level-low while any IRQ is
+// pending, so after clearing it is sampled again to catch events that
+// arrived in between.
+
+#define AXP_IRQ_FIRST 0x48
+#define AXP_IRQ_COUNT 5
+#define AXP_IRQ_RECHECKS 4          // Durchlaeufe pro Flanke, solange die Leitung low bleibt
+#define AXP_IRQ_RECHECK_NS 1000000
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
 }
 
-void interpret_battery_voltage(uint8_t reg78, uint8_t reg79) {
-    int raw = (reg78 << 4) | (reg79 & 0x0F);
-    float voltage_mV = raw * 1.1f;
-    printf("Battery Voltage         : %.1f mV (RAW: 0x%03X)\n", voltage_mV, raw);
+static int open_irq_line(const char* chip, unsigned line) {
+    int chip_fd = open(chip, O_RDONLY);
+    if (chip_fd < 0) {
+        perror("Open GPIO chip failed");
+        return -1;
+    }
+    struct gpioevent_request req;
+    memset(&req, 0, sizeof(req));
+    req.lineoffset = line;
+    req.handleflags = GPIOHANDLE_REQUEST_INPUT;
+    req.eventflags = GPIOEVENT_REQUEST_FALLING_EDGE;
+    strncpy(req.consumer_label, "axp223-irq", sizeof(req.consumer_label) - 1);
+
+    int ret = ioctl(chip_fd, GPIO_GET_LINEEVENT_IOCTL, &req);
+    close(chip_fd);
+    if (ret < 0) {
+        perror("Request GPIO line event failed");
+        return -1;
+    }
+    return req.fd;
 }
 
-void interpret_charge_current(uint8_t reg7a, uint8_t reg7b) {
-    int raw = (reg7a << 5) | (reg7b & 0x1F);
-    float current_mA = raw * 0.5f;
-    printf("Battery Charge Current  : %.1f mA (RAW: 0x%04X)\n", current_mA, raw);
+static bool irq_line_asserted(int line_fd) {
+    struct gpiohandle_data data;
+    if (ioctl(line_fd, GPIOHANDLE_GET_LINE_VALUES_IOCTL, &data) < 0)
+        return false;
+    return data.values[0] == 0;     // NMI ist low-aktiv
 }
 
-void interpret_discharge_current(uint8_t reg7c, uint8_t reg7d) {
-    int raw = (reg7c << 5) | (reg7d & 0x1F);
-    float current_mA = raw * 0.5f;
-    printf("Battery Discharge Current: %.1f mA (RAW: 0x%04X)\n", current_mA, raw);
+// Read, decode and clear the IRQ status registers. Returns -1 on bus error.
+static int handle_irq(axp_i2c_dev* dev, uint64_t t_ns, int format) {
+    static const uint8_t irq_regs[AXP_IRQ_COUNT] = { 0x48, 0x49, 0x4A, 0x4B, 0x4C };
+    axp_snapshot snap;
+    axp_snapshot_clear(&snap);
+    if (axp_i2c_read_block(dev, AXP_IRQ_FIRST, &snap.reg[AXP_IRQ_FIRST], AXP_IRQ_COUNT) < 0) {
+        perror("Read IRQ status failed");
+        return -1;
+    }
+    axp_snapshot_set_valid(&snap, AXP_IRQ_FIRST, AXP_IRQ_COUNT);
+
+    uint8_t pending = 0;
+    for (int i = 0; i < AXP_IRQ_COUNT; ++i)
+        pending |= snap.reg[AXP_IRQ_FIRST + i];
+    if (!pending)
+        return 0;
+
+    if (axp_i2c_write_regs(dev, irq_regs, &snap.reg[AXP_IRQ_FIRST], AXP_IRQ_COUNT) < 0)
+        perror("Clear IRQ status failed");
+
+    axp_out out = { decode_buf, 0, sizeof(decode_buf) };
+    if (format == AXP_FMT_TEXT) {
+        axp_out_str(&out, "=== AXP223 IRQ Event @ ");
+        axp_out_fixed(&out, t_ns / 1000, 6);
+        axp_out_str(&out, " s ===\n");
+        axp_render_range(&out, &snap, AXP_IRQ_FIRST, AXP_IRQ_FIRST + AXP_IRQ_COUNT - 1);
+    } else {
+        axp_rec rec;
+        if (format == AXP_FMT_CSV) {
+            static bool header_done;
+            if (!header_done) {
+                axp_rec_begin(&rec, &out, format, true);
+                axp_rec_key(&rec, NULL, "t_ns");
+                axp_rec_decoded(&rec, &snap, AXP_IRQ_FIRST, AXP_IRQ_FIRST + AXP_IRQ_COUNT - 1);
+                axp_rec_end(&rec);
+                header_done = true;
+            }
+        }
+        axp_rec_begin(&rec, &out, format, false);
+        if (axp_rec_key(&rec, NULL, "t_ns"))
+            axp_out_uint(&out, t_ns);
+        axp_rec_decoded(&rec, &snap, AXP_IRQ_FIRST, AXP_IRQ_FIRST + AXP_IRQ_COUNT - 1);
+        axp_rec_end(&rec);
+    }
+    axp_out_flush(&out, STDOUT_FILENO);
+    return 0;
 }
 
+int run_irq_events(axp_i2c_dev* dev, const char* chip, unsigned line, int format) {
+    int line_fd = open_irq_line(chip, line);
+    if (line_fd < 0)
+        return 1;
 
+    // Bereits anstehende IRQs abarbeiten, sonst kommt keine neue Flanke
+    handle_irq(dev, monotonic_ns(), format);
 
-void interpret_reg34(uint8_t value) {
-    printf("REG34 (Charging Control 2): 0x%02X\n", value);
-    // Bits 7–6: Pre-charge Timeout
-    const char* precharge_timeout[] = {"40 min", "50 min", "60 min", "70 min"};
-    printf("  - Pre-charge Timeout (7:6)     : %s\n", precharge_timeout[(value >> 6) & 0x03]);
-    // Bit 5: Keep charge output after full
-    printf("  - Keep Charging Output (bit 5) : %s\n", (value & 0x20) ? "Yes (remain active)" : "No (disable)");
-    // Bit 4: CHGLED Type
-    printf("  - CHGLED Mode Type (bit 4)     : %s\n", (value & 0x10) ? "Type B (blink)" : "Type A (solid/low)");
-    // Bit 2: Constant Current sync with setting
-    printf("  - Sync on Current Change (bit 2): %s\n", (value & 0x04) ? "Yes (dynamic adjust)" : "No (ignore until reset)");
-    // Bits 1–0: CC Timeout
-    const char* cc_timeout[] = {"6h", "8h", "10h", "12h"};
-    printf("  - CC Timeout (1:0)             : %s\n", cc_timeout[value & 0x03]);
-}
+    struct pollfd pfd = { .fd = line_fd, .events = POLLIN };
+    for (;;) {
+        if (poll(&pfd, 1, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("poll failed");
+            break;
+        }
 
-void interpret_reg35(uint8_t value) {
-    printf("REG35 (Charging Control 3): 0x%02X\n", value);
-
-    // Nur Bits 3–0 sind gültig
-    uint8_t cc_bits = value & 0x0F;
-    int charge_current[] = {
-        300, 450, 600, 750,
-        900, 1050, 1200, 1350,
-        1500, 1650, 1800, 1950,
-        2100, 2250, -1, -1
-    };
-    int current = charge_current[cc_bits];
-
-    if (current > 0)
-        printf("  - Loop Charging Current Limit : %d mA\n", current);
-    else
-        printf("  - Loop Charging Current Limit : Invalid/Reserved\n");
-}
+        struct gpioevent_data ev;
+        if (read(line_fd, &ev, sizeof(ev)) != sizeof(ev)) {
+            perror("Read GPIO event failed");
+            break;
+        }
 
-void interpret_adc_voltage(const char* label, uint8_t high, uint8_t low, float scale_mV) {
-    int raw = (high << 4) | (low & 0x0F);
-    float voltage = raw * scale_mV;
-    printf("%s Voltage           : %.2f mV (RAW: 0x%03X)\n", label, voltage, raw);
-}
+        // Bleibt die Leitung low, ohne dass etwas ansteht (geteilte oder
+        // haengende NMI, fehlgeschlagenes Loeschen), nach wenigen Runden
+        // zurueck zu poll() statt den Bus im Kreis zu lesen
+        uint64_t t_ns = ev.timestamp;
+        for (int pass = 1;; ++pass) {
+            if (handle_irq(dev, t_ns, format) < 0 || !irq_line_asserted(line_fd))
+                break;
+            if (pass == AXP_IRQ_RECHECKS) {
+                fprintf(stderr, "IRQ line still asserted after %d passes, waiting for the next edge\n", pass);
+                break;
+            }
+            struct timespec pause = { 0, AXP_IRQ_RECHECK_NS };
+            nanosleep(&pause, NULL);
+            t_ns = monotonic_ns();
+        }
+    }
 
-void interpret_adc_current(const char* label, uint8_t high, uint8_t low, float scale_mA) {
-    int raw = (high << 5) | (low & 0x1F);
-    float current = raw * scale_mA;
-    printf("%s Current           : %.2f mA (RAW: 0x%04X)\n", label, current, raw);
+    close(line_fd);
+    return 1;
 }
 
-void interpret_internal_temp(uint8_t high, uint8_t low) {
-    int raw = (high << 4) | (low & 0x0F);
-    float temp = raw * 0.1f - 144.7f;
-    printf("Internal Temperature   : %.1f °C (RAW: 0x%03X)\n", temp, raw);
-}
 
-void interpret_reg82(uint8_t value) {
-    printf("REG82 (ADC Enable 1): 0x%02X\n", value);
+// ==========================
+// Monitor-Modus
+// ==========================
+// Polls the register table continuously, each register at its own period:
+// by default per section, with the fast-changing status/IRQ registers of
+// otherwise static sections pulled out. Registers that fall due within
+// `slack` of each other are merged into one planned read. Text output
+// decodes what was read in a cycle; machine formats emit the full current
+// image (older values for the slow registers) once per cycle.
+
+typedef struct {
+    const char* section;    // NULL: Einzelregister `reg`
+    uint8_t reg;
+    uint32_t period_ms;
+} poll_period;
+
+static const poll_period default_periods[] = {
+    { "ADC",           0, 100 },
+    { "Interrupt",     0, 10000 },
+    { "Fuel Gauge",    0, 10000 },
+    { "GPIO",          0, 1000 },
+    { "Power Control", 0, 10000 },
+    { "Timer",         0, 10000 },
+    { NULL, 0x00, 100 },        // Power Status
+    { NULL, 0x01, 100 },        // Charge State
+    { NULL, 0x48, 100 },        // IRQ Status 1..5
+    { NULL, 0x49, 100 },
+    { NULL, 0x4A, 100 },
+    { NULL, 0x4B, 100 },
+    { NULL, 0x4C, 100 },
+    { NULL, 0x80, 10000 },      // ADC-Konfiguration
+    { NULL, 0x82, 10000 },
+    { NULL, 0x84, 10000 },
+    { NULL, 0x85, 10000 },
+    { NULL, 0xB9, 1000 },       // Fuel Gauge Result
+    { NULL, 0xE0, 60000 },      // Battery Capacity
+    { NULL, 0xE1, 60000 },
+};
+
+#define MAX_PERIOD_OVERRIDES 32
+
+static poll_period period_overrides[MAX_PERIOD_OVERRIDES];
+static size_t n_period_overrides;
 
-    printf("  - TS Pin ADC Enable           : %s\n", (value & 0x80) ? "Yes" : "No");
-    printf("  - Battery Voltage ADC Enable  : %s\n", (value & 0x40) ? "Yes" : "No");
-    printf("  - Battery Current ADC Enable  : %s\n", (value & 0x20) ? "Yes" : "No");
+// "<section>:<ms>" or "0xNN:<ms>"
+static int parse_period(const char* spec) {
+    const char* colon = strrchr(spec, ':');
+    if (!colon || n_period_overrides == MAX_PERIOD_OVERRIDES)
+        return -1;
+    poll_period* p = &period_overrides[n_period_overrides];
+    p->period_ms = strtoul(colon + 1, NULL, 10);
+    if (p->period_ms == 0)
+        return -1;
 
-    // Bits 4–0 sind nicht dokumentiert in AXP223 v1.1
-    printf("  - Other ADCs (undocumented)   : 0x%02X (raw bits 4–0)\n", value & 0x1F);
+    size_t len = colon - spec;
+    if (len > 2 && spec[0] == '0' && (spec[1] == 'x' || spec[1] == 'X')) {
+        p->section = NULL;
+        p->reg = (uint8_t)strtoul(spec, NULL, 16);
+    } else {
+        char* section = strndup(spec, len);
+        if (!section)
+            return -1;
+        p->section = section;
+    }
+    n_period_overrides++;
+    return 0;
 }
-void interpret_reg_b8(uint8_t value) {
-    printf("REG B8 (Fuel Gauge Control): 0x%02X\n", value);
-
-    printf("  - Fuel Gauge Enabled (bit 7)              : %s\n", (value & 0x80) ? "Yes" : "No");
-    printf("  - Coulomb Counter Enabled (bit 6)         : %s\n", (value & 0x40) ? "Yes" : "No");
-    printf("  - Capacity Calibration Trigger (bit 5)    : %s\n", (value & 0x20) ? "Requested" : "Not triggered");
-    printf("  - Calibration Status (bit 4)              : %s\n", (value & 0x10) ? "Not running" : "Running");
-    printf("  - Reserved Bits (3:0)                     : 0x%X\n", value & 0x0F);
+
+// Later rules win, register rules beat section rules
+static uint32_t period_lookup(const poll_period* rules, size_t n, const AXP223_Register* r, uint32_t period) {
+    for (size_t i = 0; i < n; ++i)
+        if (rules[i].section && strcasecmp(rules[i].section, r->section) == 0)
+            period = rules[i].period_ms;
+    for (size_t i = 0; i < n; ++i)
+        if (!rules[i].section && rules[i].reg == r->address)
+            period = rules[i].period_ms;
+    return period;
 }
 
-void interpret_reg_e0_e1(uint8_t reg_e0, uint8_t reg_e1) {
-    printf("REG E0 (Battery Capacity 1): 0x%02X\n", reg_e0);
-    printf("REG E1 (Battery Capacity 2): 0x%02X\n", reg_e1);
+static uint32_t register_period(const AXP223_Register* r) {
+    size_t ndef = sizeof(default_periods) / sizeof(default_periods[0]);
+    uint32_t period = period_lookup(default_periods, ndef, r, 1000);
+    return period_lookup(period_overrides, n_period_overrides, r, period);
+}
 
-    bool capacity_valid = reg_e0 & 0x80;
-    uint16_t raw = ((reg_e0 & 0x7F) << 8) | reg_e1;
-    float capacity_mAh = raw * 1.456f;
+static volatile sig_atomic_t stop_requested;
 
-    printf("  - Capacity Configured (bit 7)   : %s\n", capacity_valid ? "Yes" : "No");
-    printf("  - Raw Capacity Setting (14:0)   : %u (0x%04X)\n", raw, raw);
-    printf("  - Calculated Battery Capacity   : %.2f mAh\n", capacity_mAh);
+static void on_signal(int sig) {
+    (void)sig;
+    stop_requested = 1;
 }
 
-void interpret_reg48(uint8_t value) {
-    printf("REG 48h (IRQ Status 1): 0x%02X\n", value);
-    if (value & 0x80) puts("  - ACIN Over-Voltage");
-    if (value & 0x40) puts("  - ACIN Connected");
-    if (value & 0x20) puts("  - ACIN Removed");
-    if (value & 0x10) puts("  - VBUS Over-Voltage");
-    if (value & 0x08) puts("  - VBUS Connected");
-    if (value & 0x04) puts("  - VBUS Removed");
-    if (value & 0x02) puts("  - VBUS Below VHOLD");
+// nregs == 0: keyframe of the whole image
+static void monitor_text(const axp_snapshot* cycle, uint64_t t_ns, size_t nregs, size_t nspans) {
+    axp_out out = { decode_buf, 0, sizeof(decode_buf) };
+    axp_out_str(&out, "--- t=");
+    axp_out_fixed(&out, (int64_t)(t_ns / 1000000), 3);
+    if (nregs) {
+        axp_out_str(&out, " s: ");
+        axp_out_uint(&out, nregs);
+        axp_out_str(&out, " registers in ");
+        axp_out_uint(&out, nspans);
+        axp_out_str(&out, " spans ---\n");
+    } else {
+        axp_out_str(&out, " s: keyframe ---\n");
+    }
+    axp_render_range(&out, cycle, 0x00, 0xFF);
+    axp_out_flush(&out, STDOUT_FILENO);
 }
 
-void interpret_reg49(uint8_t value) {
-    printf("REG 49h (IRQ Status 2): 0x%02X\n", value);
-    if (value & 0x80) puts("  - Battery Connected");
-    if (value & 0x40) puts("  - Battery Removed");
-    if (value & 0x20) puts("  - Battery Entered Activate Mode");
-    if (value & 0x10) puts("  - Battery Exited Activate Mode");
-    if (value & 0x08) puts("  - Battery is Charging");
-    if (value & 0x04) puts("  - Charging Finished");
-    if (value & 0x02) puts("  - Battery Over-Temperature");
-    if (value & 0x01) puts("  - Battery Low-Temperature");
+static void monitor_record(const axp_snapshot* image, int format, const uint8_t* addrs, size_t count,
+                           uint64_t t_ns, bool header, bool keyframe) {
+    axp_out out = { decode_buf, 0, sizeof(decode_buf) };
+    axp_rec rec;
+    axp_rec_begin(&rec, &out, format, header);
+    if (axp_rec_key(&rec, NULL, "t_ms"))
+        axp_out_uint(&out, t_ns / 1000000);
+    if (keyframe && axp_rec_key(&rec, NULL, "keyframe"))
+        axp_rec_bool(&rec, true);
+    axp_rec_decoded(&rec, image, 0x00, 0xFF);
+    axp_rec_registers(&rec, image, addrs, count);
+    axp_rec_end(&rec);
+    axp_out_flush(&out, STDOUT_FILENO);
 }
 
-void interpret_reg4a(uint8_t value) {
-    printf("REG 4Ah (IRQ Status 3): 0x%02X\n", value);
-    if (value & 0x80) puts("  - Internal Over-Temperature");
-    if (value & 0x02) puts("  - PEK Short Press");
-    if (value & 0x01) puts("  - PEK Long Press");
+// Watch: only registers/fields that changed since the last output, with a
+// full keyframe every `keyframe_s` seconds (and at the start).
+static void watch_text(const axp_snapshot* last, const axp_snapshot* image, const uint32_t* changed,
+                       const uint8_t* addrs, size_t count, uint64_t t_ns) {
+    axp_out out = { decode_buf, 0, sizeof(decode_buf) };
+    axp_out_str(&out, "--- t=");
+    axp_out_fixed(&out, (int64_t)(t_ns / 1000000), 3);
+    axp_out_str(&out, " s ---\n");
+    axp_render_changes(&out, last, image, changed);
+
+    // Register ohne Decoder als Rohwert
+    for (size_t i = 0; i < count; ++i) {
+        if (!axp_bitmap_test(changed, addrs[i]) || axp_decode_covers(addrs[i]))
+            continue;
+        size_t start = out.len;
+        axp_out_str(&out, "Register ");
+        axp_out_hex(&out, addrs[i], 2);
+        axp_out_str(&out, " (");
+        axp_out_str(&out, registers[i].name);
+        axp_out_char(&out, ')');
+        axp_out_pad(&out, start, AXP_LABEL_WIDTH);
+        axp_out_str(&out, ": ");
+        if (axp_snapshot_is_valid(last, addrs[i])) {
+            axp_out_hex(&out, last->reg[addrs[i]], 2);
+            axp_out_str(&out, " -> ");
+        }
+        axp_out_hex(&out, image->reg[addrs[i]], 2);
+        axp_out_char(&out, '\n');
+    }
+    axp_out_flush(&out, STDOUT_FILENO);
 }
 
-void interpret_reg4b(uint8_t value) {
-    printf("REG 4Bh (IRQ Status 4): 0x%02X\n", value);
-    if (value & 0x02) puts("  - Battery Alarm Threshold 1 Reached");
-    if (value & 0x01) puts("  - Battery Alarm Threshold 2 Reached");
+static void watch_record(const axp_snapshot* last, const axp_snapshot* image, const uint32_t* changed,
+                         int format, const uint8_t* addrs, size_t count, uint64_t t_ns) {
+    axp_out out = { decode_buf, 0, sizeof(decode_buf) };
+    axp_rec rec;
+    axp_rec_begin(&rec, &out, format, false);
+    if (axp_rec_key(&rec, NULL, "t_ms"))
+        axp_out_uint(&out, t_ns / 1000000);
+    if (axp_rec_key(&rec, NULL, "keyframe"))
+        axp_rec_bool(&rec, false);
+    axp_rec_changes(&rec, last, image, changed, addrs, count);
+    axp_rec_end(&rec);
+    axp_out_flush(&out, STDOUT_FILENO);
 }
 
-void interpret_reg4c(uint8_t value) {
-    printf("REG 4Ch (IRQ Status 5): 0x%02X\n", value);
-    if (value & 0x80) puts("  - Timer Timeout");
-    if (value & 0x40) puts("  - PEK Rising Edge");
-    if (value & 0x20) puts("  - PEK Falling Edge");
-    if (value & 0x02) puts("  - GPIO1 Edge Trigger");
-    if (value & 0x01) puts("  - GPIO0 Edge Trigger");
-}
+int run_monitor(axp_i2c_dev* dev, unsigned gap, uint32_t slack_ms, uint32_t duration_s, int format,
+                bool watch, uint32_t keyframe_s) {
+    size_t reg_count = sizeof(registers) / sizeof(registers[0]);
+    uint8_t addrs[MAX_REGISTERS];
+    axp_sched sched;
+    axp_sched_init(&sched);
+
+    uint64_t start = monotonic_ns();
+    uint64_t fastest = UINT64_MAX;
+    for (size_t i = 0; i < reg_count; ++i) {
+        uint32_t period = register_period(&registers[i]);
+        addrs[i] = registers[i].address;
+        axp_sched_add(&sched, registers[i].address, period, start);
+        if (period < fastest)
+            fastest = period;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    axp_snapshot image, cycle;
+    axp_snapshot_clear(&image);
+    if (format == AXP_FMT_CSV)
+        monitor_record(&image, format, addrs, reg_count, 0, true, false);
+    axp_snapshot last;              // Stand der letzten Watch-Ausgabe
+    axp_snapshot_clear(&last);
+    uint64_t next_keyframe = start;
+    uint64_t cycles = 0, xfers = 0, bytes = 0, errors = 0, read_max = 0;
+    uint64_t end = duration_s ? start + (uint64_t)duration_s * 1000000000ull : UINT64_MAX;
+
+    while (!stop_requested) {
+        uint64_t due = axp_sched_next(&sched);
+        if (due >= end)
+            break;
+        struct timespec ts = { due / 1000000000ull, due % 1000000000ull };
+        int rc = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+        if (rc == EINTR)
+            continue;
+
+        uint64_t now = monotonic_ns();
+        uint8_t regs[256];
+        size_t nregs = axp_sched_pop_due(&sched, now, (uint64_t)slack_ms * 1000000ull, regs);
+        if (nregs == 0)
+            continue;
+
+        axp_i2c_span spans[AXP_I2C_MAX_SPANS];
+        size_t nspans = axp_i2c_plan_reads(regs, nregs, gap, spans, AXP_I2C_MAX_SPANS);
+        if (axp_snapshot_read(dev, &cycle, spans, nspans) < 0) {
+            perror("Read due registers failed");
+            errors++;
+        }
+        uint64_t read_ns = monotonic_ns() - now;
+        if (read_ns > read_max)
+            read_max = read_ns;
+
+        cycles++;
+        xfers += (nspans + AXP_I2C_READS_PER_XFER - 1) / AXP_I2C_READS_PER_XFER;
+        for (size_t i = 0; i < nspans; ++i)
+            bytes += 3 + spans[i].len;      // Adresse + Pointer, Adresse + Daten
+        for (int r = 0; r < 256; ++r) {
+            if (axp_snapshot_is_valid(&cycle, r)) {
+                image.reg[r] = cycle.reg[r];
+                axp_snapshot_set_valid(&image, r, 1);
+            }
+        }
+        // Fehlgeschlagene Reads sind unbekannt, nicht "alter Wert"
+        for (size_t i = 0; i < nregs; ++i)
+            if (!axp_snapshot_is_valid(&cycle, regs[i]))
+                axp_snapshot_set_invalid(&image, regs[i], 1);
+
+        if (!watch) {
+            if (format == AXP_FMT_TEXT)
+                monitor_text(&cycle, now - start, nregs, nspans);
+            else
+                monitor_record(&image, format, addrs, reg_count, now - start, false, false);
+            continue;
+        }
+
+        if (now >= next_keyframe) {
+            if (format == AXP_FMT_TEXT)
+                monitor_text(&image, now - start, 0, 0);
+            else
+                monitor_record(&image, format, addrs, reg_count, now - start, false, true);
+            next_keyframe = now + (uint64_t)keyframe_s * 1000000000ull;
+            last = image;
+            continue;
+        }
+
+        uint32_t changed[256 / 32];
+        if (axp_snapshot_diff(&last, &image, changed) == 0)
+            continue;
+        if (format == AXP_FMT_TEXT)
+            watch_text(&last, &image, changed, addrs, reg_count, now - start);
+        else
+            watch_record(&last, &image, changed, format, addrs, reg_count, now - start);
+        last = image;
+    }
 
-void interpret_all_irq_status(int fd) {
-    uint8_t r48 = read_reg(fd, 0x48);
-    uint8_t r49 = read_reg(fd, 0x49);
-    uint8_t r4a = read_reg(fd, 0x4A);
-    uint8_t r4b = read_reg(fd, 0x4B);
-    uint8_t r4c = read_reg(fd, 0x4C);
-
-    printf("=== AXP223 IRQ Status Overview ===\n");
-    interpret_reg48(r48);
-    interpret_reg49(r49);
-    interpret_reg4a(r4a);
-    interpret_reg4b(r4b);
-    interpret_reg4c(r4c);
+    // Vergleich: ganze Tabelle mit der schnellsten Periode lesen
+    uint64_t elapsed = monotonic_ns() - start;
+    axp_i2c_span spans[AXP_I2C_MAX_SPANS];
+    size_t nspans = axp_i2c_plan_reads(addrs, reg_count, gap, spans, AXP_I2C_MAX_SPANS);
+    uint64_t full_bytes = 0;
+    for (size_t i = 0; i < nspans; ++i)
+        full_bytes += 3 + spans[i].len;
+    uint64_t full_cycles = elapsed / (fastest * 1000000ull) + 1;
+
+    fprintf(stderr, "monitor: %llu cycles, %llu transactions, %llu bytes, %llu errors in %.1f s "
+                    "(full table every %llu ms: %llu bytes, %.1fx), slowest cycle %.1f ms\n",
+            (unsigned long long)cycles, (unsigned long long)xfers, (unsigned long long)bytes,
+            (unsigned long long)errors, elapsed / 1e9, (unsigned long long)fastest,
+            (unsigned long long)(full_cycles * full_bytes),
+            bytes ? (double)(full_cycles * full_bytes) / bytes : 0.0, read_max / 1e6);
+    axp_i2c_report(dev, "monitor");
+    return errors ? 1 : 0;
 }
 
+// ==========================
+// Feldabfrage (--get)
+// ==========================
+// Resolves field keys ("battery_voltage", "irq.pek_short", "reg.0x33") to
+// their source registers through the decoder table, reads exactly those
+// registers with one planned transaction and emits one record with only
+// the requested values, in the order given. Text output is key=value.
 
-void read_and_interpret_registers(int fd) {
-    // === Einzelregister lesen ===
-    uint8_t reg00 = read_reg(fd, 0x00);
-    uint8_t reg01 = read_reg(fd, 0x01);
-    uint8_t reg32 = read_reg(fd, 0x32);
-    uint8_t reg33 = read_reg(fd, 0x33);
-    uint8_t reg34 = read_reg(fd, 0x34);
-    uint8_t reg35 = read_reg(fd, 0x35);
-    uint8_t reg82 = read_reg(fd, 0x82);
-    uint8_t regB8 = read_reg(fd, 0xB8);
-    uint8_t regE0 = read_reg(fd, 0xE0);
-    uint8_t regE1 = read_reg(fd, 0xE1);
-
-    // === Paare lesen (für ADCs etc.) ===
-    uint8_t reg78 = read_reg(fd, 0x78);
-    uint8_t reg79 = read_reg(fd, 0x79);
-    uint8_t reg7A = read_reg(fd, 0x7A);
-    uint8_t reg7B = read_reg(fd, 0x7B);
-    uint8_t reg7C = read_reg(fd, 0x7C);
-    uint8_t reg7D = read_reg(fd, 0x7D);
-    uint8_t reg56 = read_reg(fd, 0x56);
-    uint8_t reg57 = read_reg(fd, 0x57);
-
-    // === IRQ Statusregister ===
-    uint8_t reg48 = read_reg(fd, 0x48);
-    uint8_t reg49 = read_reg(fd, 0x49);
-    uint8_t reg4A = read_reg(fd, 0x4A);
-    uint8_t reg4B = read_reg(fd, 0x4B);
-    uint8_t reg4C = read_reg(fd, 0x4C);
-
-    // === Interpretation in klarer Reihenfolge ===
-    printf("\n=== AXP223 Register Interpretation ===\n");
-    interpret_reg00(reg00);
-    interpret_reg01(reg01);
-    interpret_reg32(reg32);
-    interpret_reg33(reg33);
-    interpret_reg34(reg34);
-    interpret_reg35(reg35);
-    interpret_battery_voltage(reg78, reg79);
-    interpret_charge_current(reg7A, reg7B);
-    interpret_discharge_current(reg7C, reg7D);
-    interpret_internal_temp(reg56, reg57);
-    interpret_reg82(reg82);
-    interpret_reg_b8(regB8);
-    interpret_reg_e0_e1(regE0, regE1);
-    interpret_reg48(reg48);
-    interpret_reg49(reg49);
-    interpret_reg4a(reg4A);
-    interpret_reg4b(reg4B);
-    interpret_reg4c(reg4C);
+#define MAX_QUERY 64
+
+typedef struct {
+    const axp_reg_desc* desc;   // NULL: Rohregister
+    const axp_field* field;
+    uint8_t reg;
+} query_item;
+
+static int parse_query(const char* list, query_item* items, size_t* count) {
+    char buf[1024];
+    snprintf(buf, sizeof(buf), "%s", list);
+    *count = 0;
+    for (char* save = NULL, *key = strtok_r(buf, ",", &save); key; key = strtok_r(NULL, ",", &save)) {
+        if (*count == MAX_QUERY) {
+            fprintf(stderr, "More than %d fields in --get\n", MAX_QUERY);
+            return -1;
+        }
+        query_item* q = &items[*count];
+        if (strncmp(key, "reg.", 4) == 0) {
+            char* end;
+            unsigned long reg = strtoul(key + 4, &end, 16);
+            if (*end || end == key + 4 || reg > 0xFF) {
+                fprintf(stderr, "Invalid register in --get: %s\n", key);
+                return -1;
+            }
+            *q = (query_item){ NULL, NULL, (uint8_t)reg };
+        } else {
+            q->desc = axp_decode_find(key, &q->field);
+            if (!q->desc) {
+                axp_decode_explain(stderr, "field in --get", key);
+                return -1;
+            }
+            q->reg = q->desc->reg;
+        }
+        (*count)++;
+    }
+    return *count ? 0 : -1;
 }
 
+static int run_query(axp_i2c_dev* dev, const query_item* items, size_t count, unsigned gap, int format) {
+    uint8_t regs[256];
+    size_t nregs = 0;
+    for (size_t i = 0; i < count; ++i) {
+        regs[nregs++] = items[i].reg;
+        if (items[i].desc && items[i].desc->nregs == 2)
+            regs[nregs++] = items[i].reg + 1;
+    }
+
+    axp_i2c_span spans[AXP_I2C_MAX_SPANS];
+    size_t nspans = axp_i2c_plan_reads(regs, nregs, gap, spans, AXP_I2C_MAX_SPANS);
+    axp_snapshot snap;
+    int ret = axp_snapshot_read(dev, &snap, spans, nspans);
+    if (ret < 0)
+        perror("Read queried registers failed");
+
+    axp_out out = { decode_buf, 0, sizeof(decode_buf) };
+    axp_rec rec;
+    if (format == AXP_FMT_TEXT)
+        format = AXP_FMT_KV;
+    for (int pass = format == AXP_FMT_CSV ? 0 : 1; pass < 2; ++pass) {
+        axp_rec_begin(&rec, &out, format, pass == 0);
+        for (size_t i = 0; i < count; ++i) {
+            const query_item* q = &items[i];
+            if (!q->desc) {
+                axp_rec_registers(&rec, &snap, &q->reg, 1);
+                continue;
+            }
+            if (!axp_rec_key(&rec, q->desc->group, q->field->key))
+                continue;
+            if (axp_snapshot_has(&snap, q->desc->reg, q->desc->nregs))
+                axp_rec_field(&rec, q->field, axp_desc_raw(q->desc, snap.reg));
+            else
+                axp_rec_null(&rec);
+        }
+        axp_rec_end(&rec);
+    }
+    axp_out_flush(&out, STDOUT_FILENO);
+    return ret < 0 ? 1 : 0;
+}
 
 // ==========================
 // Main
 // ==========================
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        fprintf(stderr, "Usage: %s <i2c-bus> <device-address-hex>\n", argv[0]);
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <i2c-bus> <device-address-hex> [--gap=N] [--format=text|json|csv|kv]\n"
+                        "       %s <i2c-bus> <device-address-hex> --irq=<gpiochip>:<line> [--format=...]\n"
+                        "       %s <i2c-bus> <device-address-hex> --monitor[=SECONDS] [--period=<section|0xNN>:<ms>]... "
+                        "[--slack=MS] [--gap=N] [--format=...]\n"
+                        "       %s <i2c-bus> <device-address-hex> --watch [--keyframe=SECONDS] [monitor options]\n"
+                        "       %s <i2c-bus> <device-address-hex> --get=<field>[,<field>...] [--format=...]\n",
+                argv[0], argv[0], argv[0], argv[0], argv[0]);
         return 1;
     }
 
     const char* i2c_bus = argv[1];
     int addr = (int)strtol(argv[2], NULL, 16);
+    unsigned gap = AXP_I2C_DEFAULT_GAP;
+    int format = AXP_FMT_TEXT;
+    const char* irq_spec = NULL;
+    query_item query[MAX_QUERY];
+    size_t nquery = 0;
+    bool monitor = false, watch = false;
+    uint32_t duration_s = 0, slack_ms = 5, keyframe_s = 60;
+    for (int i = 3; i < argc; ++i) {
+        if (strncmp(argv[i], "--gap=", 6) == 0) {
+            gap = (unsigned)strtoul(argv[i] + 6, NULL, 10);
+        } else if (strncmp(argv[i], "--format=", 9) == 0) {
+            format = axp_parse_format(argv[i] + 9);
+            if (format < 0) {
+                fprintf(stderr, "Unknown format: %s\n", argv[i] + 9);
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--get=", 6) == 0) {
+            if (parse_query(argv[i] + 6, query, &nquery) < 0)
+                return 1;
+        } else if (strncmp(argv[i], "--irq=", 6) == 0) {
+            irq_spec = argv[i] + 6;
+        } else if (strcmp(argv[i], "--monitor") == 0) {
+            monitor = true;
+        } else if (strncmp(argv[i], "--monitor=", 10) == 0) {
+            monitor = true;
+            duration_s = strtoul(argv[i] + 10, NULL, 10);
+        } else if (strcmp(argv[i], "--watch") == 0) {
+            monitor = watch = true;
+        } else if (strncmp(argv[i], "--keyframe=", 11) == 0) {
+            keyframe_s = strtoul(argv[i] + 11, NULL, 10);
+        } else if (strncmp(argv[i], "--period=", 9) == 0) {
+            if (parse_period(argv[i] + 9) < 0) {
+                fprintf(stderr, "Invalid --period, expected <section|0xNN>:<ms>\n");
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--slack=", 8) == 0) {
+            slack_ms = strtoul(argv[i] + 8, NULL, 10);
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
 
-    int fd = open(i2c_bus, O_RDWR);
-    if (fd < 0) {
+    axp_i2c_dev dev;
+    if (axp_i2c_open(&dev, i2c_bus, addr) < 0) {
         perror("Open I2C bus failed");
         return 1;
     }
+    gap = axp_i2c_plan_gap(&dev, gap);
+
+    if (irq_spec) {
+        // z.B. /dev/gpiochip0:35
+        char chip[64];
+        const char* colon = strrchr(irq_spec, ':');
+        if (!colon || (size_t)(colon - irq_spec) >= sizeof(chip)) {
+            fprintf(stderr, "Invalid --irq, expected <gpiochip>:<line>\n");
+            axp_i2c_close(&dev);
+            return 1;
+        }
+        memcpy(chip, irq_spec, colon - irq_spec);
+        chip[colon - irq_spec] = '\0';
+        int ret = run_irq_events(&dev, chip, (unsigned)strtoul(colon + 1, NULL, 10), format);
+        axp_i2c_close(&dev);
+        return ret;
+    }
 
-    if (ioctl(fd, I2C_SLAVE, addr) < 0) {
-        perror("Set I2C address failed");
-        close(fd);
+    if (nquery) {
+        int ret = run_query(&dev, query, nquery, gap, format);
+        axp_i2c_close(&dev);
+        return ret;
+    }
+
+    if (watch && format == AXP_FMT_CSV) {
+        fprintf(stderr, "--watch emits varying keys, use --format=json or kv\n");
+        axp_i2c_close(&dev);
         return 1;
     }
+    if (monitor) {
+        int ret = run_monitor(&dev, gap, slack_ms, duration_s, format, watch, keyframe_s);
+        axp_i2c_close(&dev);
+        return ret;
+    }
 
+    // Tabelle in zusammenhaengende Block-Reads aufteilen
     size_t reg_count = sizeof(registers) / sizeof(registers[0]);
+    uint8_t addrs[MAX_REGISTERS];
+    for (size_t i = 0; i < reg_count; ++i)
+        addrs[i] = registers[i].address;
+
+    axp_i2c_span spans[AXP_I2C_MAX_SPANS];
+    size_t nspans = axp_i2c_plan_reads(addrs, reg_count, gap, spans, AXP_I2C_MAX_SPANS);
+
+    // Ein Snapshot fuer Tabelle und Interpretation
+    axp_snapshot snap;
+    int ret = axp_snapshot_read(&dev, &snap, spans, nspans) < 0 ? 1 : 0;
+    if (ret)
+        perror("Read register table failed");
+    axp_i2c_close(&dev);
+
+    if (format != AXP_FMT_TEXT) {
+        print_machine(&snap, format, addrs, reg_count);
+        return ret;
+    }
+
     for (size_t i = 0; i < reg_count; ++i) {
-        int val = read_reg(fd, registers[i].address);
-        if (val < 0) {
+        if (!axp_snapshot_is_valid(&snap, registers[i].address)) {
             fprintf(stderr, "Failed to read register 0x%02X\n", registers[i].address);
             continue;
         }
-        registers[i].value = val;
+        registers[i].value = snap.reg[registers[i].address];
     }
 
-    print_table(registers, reg_count);
-	read_and_interpret_registers(fd);
-    close(fd);
-    return 0;
+    print_table(registers, reg_count, &snap);
+    interpret_registers(&snap);
+    return ret;
 }
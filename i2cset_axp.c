@@ -1,41 +1,226 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <fcntl.h>
-#include <unistd.h>
-#include <sys/ioctl.h>
-#include <linux/i2c-dev.h>
+#include <string.h>
+#include <ctype.h>
+#include "axp223_i2c.h"
+#include "axp223_regs.h"
+
+// ==========================
+// Batch-Modus
+// ==========================
+// A batch is a list of "reg value [mask]" lines (hex, '#' starts a comment).
+// Masked entries are read-modify-write: new = (old & ~mask) | (value & mask).
+// The write-1-to-clear IRQ status registers are never merged with their old
+// value, which would clear every other pending bit as well; there the mask
+// only selects which bits of `value` are written.
+// All registers that need their old value are fetched in one snapshot
+// read, and all writes (plus optional read-back) go out in one I2C_RDWR
+// transaction.
+
+typedef struct {
+    uint8_t reg;
+    uint8_t value;
+    uint8_t mask;
+} batch_entry;
+
+typedef struct {
+    batch_entry entries[256];
+    size_t count;
+} batch;
+
+// Merge into an existing entry for the same register, so later lines
+// refine earlier ones instead of writing the register twice.
+static void batch_add(batch* b, uint8_t reg, uint8_t value, uint8_t mask) {
+    for (size_t i = 0; i < b->count; ++i) {
+        batch_entry* e = &b->entries[i];
+        if (e->reg == reg) {
+            e->value = (e->value & ~mask) | (value & mask);
+            e->mask |= mask;
+            return;
+        }
+    }
+    b->entries[b->count++] = (batch_entry){ reg, value & mask, mask };
+}
+
+static int parse_batch(FILE* f, const char* name, batch* b) {
+    char line[256];
+    int lineno = 0;
+
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        char* hash = strchr(line, '#');
+        if (hash)
+            *hash = '\0';
+
+        char* p = line;
+        while (isspace((unsigned char)*p))
+            p++;
+        if (*p == '\0')
+            continue;
+
+        unsigned long v[3];
+        int n = 0;
+        while (*p && n < 3) {
+            char* end;
+            v[n] = strtoul(p, &end, 16);
+            if (end == p || v[n] > 0xFF) {
+                fprintf(stderr, "%s:%d: invalid value\n", name, lineno);
+                return -1;
+            }
+            n++;
+            p = end;
+            while (isspace((unsigned char)*p))
+                p++;
+        }
+        if (n < 2 || *p) {
+            fprintf(stderr, "%s:%d: expected <reg> <value> [mask]\n", name, lineno);
+            return -1;
+        }
+        batch_add(b, v[0], v[1], n == 3 ? v[2] : 0xFF);
+    }
+    return 0;
+}
+
+static int apply_batch(axp_i2c_dev* dev, batch* b, bool verify, bool dry_run) {
+    uint8_t regs[256], values[256], readback[256];
+
+    // Alte Werte fuer alle maskierten Register in einem Snapshot lesen
+    uint8_t rmw[256];
+    size_t nrmw = 0;
+    for (size_t i = 0; i < b->count; ++i)
+        if (b->entries[i].mask != 0xFF && !register_w1c(b->entries[i].reg))
+            rmw[nrmw++] = b->entries[i].reg;
+
+    axp_snapshot snap;
+    axp_snapshot_clear(&snap);
+    if (nrmw > 0) {
+        axp_i2c_span spans[AXP_I2C_MAX_SPANS];
+        size_t nspans = axp_i2c_plan_reads(rmw, nrmw, 0, spans, AXP_I2C_MAX_SPANS);
+        if (axp_snapshot_read(dev, &snap, spans, nspans) < 0) {
+            perror("Read for read-modify-write failed");
+            return 1;
+        }
+    }
+
+    for (size_t i = 0; i < b->count; ++i) {
+        const batch_entry* e = &b->entries[i];
+        uint8_t old = e->mask == 0xFF || register_w1c(e->reg) ? 0 : snap.reg[e->reg];
+        regs[i] = e->reg;
+        values[i] = (old & ~e->mask) | e->value;
+    }
+
+    if (dry_run) {
+        for (size_t i = 0; i < b->count; ++i) {
+            if (b->entries[i].mask == 0xFF || register_w1c(regs[i]))
+                printf("0x%02X <- 0x%02X\n", regs[i], values[i]);
+            else
+                printf("0x%02X <- 0x%02X (was 0x%02X, mask 0x%02X)\n",
+                       regs[i], values[i], snap.reg[regs[i]], b->entries[i].mask);
+        }
+        return 0;
+    }
+
+    int ret = verify ? axp_i2c_write_verify(dev, regs, values, readback, b->count)
+                     : axp_i2c_write_regs(dev, regs, values, b->count);
+    if (ret < 0) {
+        perror("Batch write failed");
+        return 1;
+    }
+
+    int mismatches = 0;
+    if (verify) {
+        for (size_t i = 0; i < b->count; ++i) {
+            // W1C: die geschriebenen Bits muessen jetzt 0 lesen, der Rest ist offen
+            if (register_w1c(regs[i]) && (readback[i] & values[i])) {
+                fprintf(stderr, "Verify 0x%02X: cleared 0x%02X, still set 0x%02X\n",
+                        regs[i], values[i], readback[i] & values[i]);
+                mismatches++;
+            } else if (!register_w1c(regs[i]) && readback[i] != values[i]) {
+                fprintf(stderr, "Verify 0x%02X: wrote 0x%02X, read 0x%02X\n",
+                        regs[i], values[i], readback[i]);
+                mismatches++;
+            }
+        }
+    }
+
+    printf("Wrote %zu registers on device 0x%02X%s\n", b->count, dev->addr,
+           verify ? (mismatches ? ", verify FAILED" : ", verified") : "");
+    return mismatches ? 2 : 0;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr, "Usage: %s <i2c-bus> <i2c-addr> <register> <value>\n"
+                    "       %s <i2c-bus> <i2c-addr> --batch=<file|-> [--verify] [--dry-run]\n",
+            prog, prog);
+}
 
 int main(int argc, char **argv) {
-    if (argc != 5) {
-        fprintf(stderr, "Usage: %s <i2c-bus> <i2c-addr> <register> <value>\n", argv[0]);
+    if (argc < 4) {
+        usage(argv[0]);
         return 1;
     }
 
-    const char* dev = argv[1];
+    const char* dev_path = argv[1];
     int addr = (int)strtol(argv[2], NULL, 16);
-    int reg = (int)strtol(argv[3], NULL, 16);
-    int val = (int)strtol(argv[4], NULL, 16);
 
-    int file = open(dev, O_RDWR);
-    if (file < 0) {
-        perror("Open i2c bus failed");
-        return 1;
+    if (strncmp(argv[3], "--batch=", 8) != 0) {
+        if (argc != 5) {
+            usage(argv[0]);
+            return 1;
+        }
+        uint8_t reg = (uint8_t)strtol(argv[3], NULL, 16);
+        uint8_t val = (uint8_t)strtol(argv[4], NULL, 16);
+
+        axp_i2c_dev dev;
+        if (axp_i2c_open(&dev, dev_path, addr) < 0) {
+            perror("Open i2c bus failed");
+            return 1;
+        }
+        if (axp_i2c_write_regs(&dev, &reg, &val, 1) < 0) {
+            perror("Write failed");
+            axp_i2c_close(&dev);
+            return 1;
+        }
+        printf("Wrote 0x%02X to register 0x%02X on device 0x%02X\n", val, reg, addr);
+        axp_i2c_close(&dev);
+        return 0;
     }
 
-    if (ioctl(file, I2C_SLAVE, addr) < 0) {
-        perror("Select i2c device failed");
-        close(file);
-        return 1;
+    const char* script = argv[3] + 8;
+    bool verify = false, dry_run = false;
+    for (int i = 4; i < argc; ++i) {
+        if (strcmp(argv[i], "--verify") == 0) {
+            verify = true;
+        } else if (strcmp(argv[i], "--dry-run") == 0) {
+            dry_run = true;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
     }
 
-    unsigned char buf[2] = { reg, val };
-    if (write(file, buf, 2) != 2) {
-        perror("Write failed");
-        close(file);
+    static batch b;
+    FILE* f = strcmp(script, "-") == 0 ? stdin : fopen(script, "r");
+    if (!f) {
+        perror("Open batch file failed");
+        return 1;
+    }
+    int parsed = parse_batch(f, script, &b);
+    if (f != stdin)
+        fclose(f);
+    if (parsed < 0)
+        return 1;
+    if (b.count == 0) {
+        fprintf(stderr, "Batch is empty\n");
         return 1;
     }
 
-    printf("Wrote 0x%02X to register 0x%02X on device 0x%02X\n", val, reg, addr);
-    close(file);
-    return 0;
+    axp_i2c_dev dev;
+    if (axp_i2c_open(&dev, dev_path, addr) < 0) {
+        perror("Open i2c bus failed");
+        return 1;
+    }
+    int ret = apply_batch(&dev, &b, verify, dry_run);
+    axp_i2c_close(&dev);
+    return ret;
 }